@@ -24,6 +24,18 @@ namespace Robot
             static const int PARAM_BYTES = 5;
 
 
+            // AX, RX, EX and MX (Protocol 1.0 firmware) servos, which share this table
+            static bool IsModel(int model)
+            {
+                switch (model)
+                    {
+                    case 12: case 18: case 24: case 28: case 29: case 44:
+                    case 64: case 107: case 310: case 320: case 360:
+                        return true;
+                    }
+                return false;
+            }
+
             static int GetMirrorValue(int value)        { return MAX_VALUE + 1 - value; }
             static double GetMirrorAngle(double angle)  { return -angle; }
             static int Angle2Value(double angle) { return (int)(angle * RATIO_ANGLE2VALUE) + CENTER_VALUE; }
@@ -75,6 +75,7 @@ namespace Robot
 		private:
 			static Action* m_UniqueInstance;
 			FILE* m_ActionFile;
+			PAGE m_Page[MAXNUM_PAGE];	// the whole file, pages are not read on the motion thread
 			PAGE m_PlayPage;
 			PAGE m_NextPlayPage;
 			STEP m_CurrentStep;
@@ -88,9 +89,12 @@ namespace Robot
 			bool m_Playing;
 			bool m_StopPlaying;
 			bool m_PlayingFinished;
+			double m_UnitTime;		// msec the playback is behind, one step is TIME_UNIT
 
 			Action();
 
+			void Step();
+
 			bool VerifyChecksum( PAGE *pPage );
 			void SetChecksum( PAGE *pPage );
 
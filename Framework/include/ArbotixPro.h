@@ -9,25 +9,116 @@
 #define _ARBOTIXPRO_H_
 
 #include "AXDXL.h"
+#include "JointData.h"
+#include "BusStatistics.h"
+#include "CommandQueue.h"
+#include "ShadowTable.h"
+#include "PacketCapture.h"
 
 #define MAXNUM_TXPARAM      (256)
 #define MAXNUM_RXPARAM      (1024)
+#define MAXNUM_TABLE        (256)   // every address of a 1 byte address space
+#define MAXNUM_TXPACKET     (3 * MAXNUM_TXPARAM)    // largest packet on the wire (Protocol 2.0 with byte stuffing)
+#define MAXNUM_TXQUEUE      (3 * MAXNUM_TXPACKET)
 
 namespace Robot
 {
+	class PlatformArbotixPro;
+
 	class BulkReadData
 	{
 		public:
 			int start_address;
 			int length;
 			int error;
-			unsigned char table[AXDXL::MAXNUM_ADDRESS];
+			unsigned char table[MAXNUM_TABLE];
+			bool received[MAXNUM_TABLE];	// ever stored by a bulk read
 
 			BulkReadData();
 			virtual ~BulkReadData() {}
 
+			// last value received, 0 if never; Contains() tells if it came with the last read
 			int ReadByte(int address);
 			int ReadWord(int address);
+			bool Contains(int address, int num);
+	};
+
+	// Joint values of ArbotixPro::CapturePose(), indexed by ID. A joint that
+	// did not answer the last capture has valid false and keeps old values.
+	class Pose
+	{
+		public:
+			bool valid[JointData::NUMBER_OF_JOINTS];
+			int torque[JointData::NUMBER_OF_JOINTS];
+			int slope[JointData::NUMBER_OF_JOINTS];
+			int goal[JointData::NUMBER_OF_JOINTS];
+			int position[JointData::NUMBER_OF_JOINTS];
+			int speed[JointData::NUMBER_OF_JOINTS];
+			int load[JointData::NUMBER_OF_JOINTS];
+			int voltage[JointData::NUMBER_OF_JOINTS];
+			int temperature[JointData::NUMBER_OF_JOINTS];
+
+			Pose();
+	};
+
+	// Decodes status packets in place in a ring buffer as they arrive, Protocol
+	// 2.0 ones handed out in the Protocol 1.0 layout (LENGTH capped at 255).
+	class StatusPacketParser
+	{
+		public:
+			enum
+			{
+				RING_SIZE = 2048 // must be a power of two
+			};
+
+			enum
+			{
+				PACKET_NONE,
+				PACKET_OK,
+				PACKET_CORRUPT
+			};
+
+		private:
+			enum
+			{
+				WAIT_HEADER1,
+				WAIT_HEADER2,
+				WAIT_HEADER3,		// Protocol 2.0 0xFD
+				WAIT_RESERVED,		// Protocol 2.0 0x00
+				WAIT_ID,
+				WAIT_LENGTH,
+				WAIT_LENGTH_H,		// Protocol 2.0
+				WAIT_DATA
+			};
+
+			unsigned char m_Ring[RING_SIZE];
+			unsigned int m_Head;		// next byte to be written
+			unsigned int m_Start;		// first byte of the packet being decoded
+			unsigned int m_Pos;			// next byte to be decoded
+			unsigned int m_Received;
+			int m_State;
+			int m_Index;
+			unsigned char m_Checksum;
+			int m_Protocol;
+			int m_Length;				// Protocol 2.0 LENGTH field
+			int m_Output;				// unstuffed bytes of the instruction and parameters
+			int m_Stuffing;				// matched bytes of the 0xFF 0xFF 0xFD pattern
+			int m_Instruction;
+			unsigned short m_CRC;
+			int m_PacketLength;
+			PacketCapture *m_Capture;
+
+		public:
+			StatusPacketParser();
+
+			void Reset();
+			void SetProtocol(int protocol)	{ m_Protocol = protocol; Reset(); }
+			void SetCapture(PacketCapture *capture)	{ m_Capture = capture; }
+			int Fill(PlatformArbotixPro *platform, bool debug);
+			int Parse(unsigned char *packet);
+			unsigned int GetReceived()		{ return m_Received; }
+			// LENGTH of the last packet (number of parameters + 2), not limited to 255
+			int GetLength()					{ return m_PacketLength; }
 	};
 
 	class PlatformArbotixPro
@@ -43,13 +134,11 @@ namespace Robot
 			virtual int ReadPort(unsigned char* packet, int numPacket) = 0;
 			virtual void FlushPort() = 0;
 
-			// Using semaphore
-			virtual void LowPriorityWait() = 0;
-			virtual void MidPriorityWait() = 0;
-			virtual void HighPriorityWait() = 0;
-			virtual void LowPriorityRelease() = 0;
-			virtual void MidPriorityRelease() = 0;
-			virtual void HighPriorityRelease() = 0;
+			// Bus arbitration
+			// priority 0: motion, 1: control table, 2: others
+			// duration: estimated msec the transaction keeps the bus
+			virtual void AcquireBus(int priority, double duration) = 0;
+			virtual void ReleaseBus(int priority) = 0;
 
 			// Using timeout
 			virtual void SetPacketTimeout(int lenPacket) = 0;
@@ -58,6 +147,7 @@ namespace Robot
 			virtual void SetUpdateTimeout(int msec) = 0;
 			virtual bool IsUpdateTimeout() = 0;
 			virtual double GetUpdateTime() = 0;
+			virtual double GetCurrentTime() = 0; // monotonic msec
 
 			virtual void Sleep(int Miliseconds) = 0;
 			//////////////////////////////////////////////////////////////////////////////
@@ -155,22 +245,98 @@ namespace Robot
 				ID_BROADCAST	= 254
 			};
 
+			// framing on the wire, selected per port
+			enum
+			{
+				PROTOCOL_1		= 1,
+				PROTOCOL_2		= 2	// byte stuffing, CRC-16 and Fast Bulk Read
+			};
+
+			// per-joint feedback fields gathered by the per-tick bulk read
+			enum
+			{
+				FEEDBACK_NONE			= 0,
+				FEEDBACK_POSITION		= 1,	// P_PRESENT_POSITION_L/H
+				FEEDBACK_SPEED			= 2,	// P_PRESENT_SPEED_L/H
+				FEEDBACK_LOAD			= 4,	// P_PRESENT_LOAD_L/H
+				FEEDBACK_VOLTAGE		= 8,	// P_PRESENT_VOLTAGE
+				FEEDBACK_TEMPERATURE	= 16	// P_PRESENT_TEMPERATURE
+			};
+
+			// commanded state, captured by CapturePose() along with FEEDBACK_xxx
+			enum
+			{
+				POSE_TORQUE				= 32,	// P_TORQUE_ENABLE
+				POSE_SLOPE				= 64,	// P_CW_COMPLIANCE_SLOPE
+				POSE_GOAL				= 128	// P_GOAL_POSITION_L/H
+			};
+
+			enum
+			{
+				QUARANTINE_MISSES		= 3		// bulk reads in a row a joint may miss
+			};
+
 		private:
 			PlatformArbotixPro *m_Platform;
-			static const int RefreshTime = 6; //msec
+			double m_RefreshTime;		// msec of bus time in one tick
 			unsigned char m_ControlTable[MAXNUM_ADDRESS];
 			unsigned char m_BulkReadTxPacket[MAXNUM_TXPARAM + 10];
+			StatusPacketParser m_RxParser;
+			BusStatistics m_Statistics;
+			int m_Protocol;
+			int m_Feedback[JointData::NUMBER_OF_JOINTS];
+			bool m_FeedbackChanged;
+			int m_SlowFeedback;			// FEEDBACK_xxx read from a few joints per tick in turn
+			int m_SlowBytes;			// bulk read bytes per tick for them
+			int m_SlowRoom;				// the same, at least one joint's, with the spare bus time
+			int m_SlowTotal;			// bytes they add to the bulk read of every joint
+			int m_SlowNext;				// next bulk read entry in turn
+			int m_NumSlow;				// entries extended this tick
+			int m_SlowEntry[JointData::NUMBER_OF_JOINTS];
+			int m_SlowLength[JointData::NUMBER_OF_JOINTS];	// length of the entry before it was extended
+			int m_SlowAddress[JointData::NUMBER_OF_JOINTS];
+			double m_Baudrate;			// bps
+			int m_ReturnDelayTime;		// servo P_RETURN_DELAY_TIME (2usec unit)
+			int m_PowerOnSettleTime;	// msec
+			bool m_HasBoard;			// the Arbotix Pro is on this port
+			bool m_Attached[JointData::NUMBER_OF_JOINTS];
+			int m_Misses[JointData::NUMBER_OF_JOINTS];			// bulk reads missed in a row
+			volatile bool m_Quarantined[JointData::NUMBER_OF_JOINTS];
+			int m_ReprobeNext;
+			double m_BulkReadTime;		// msec
+			bool m_BulkReadPending;		// a bulk read response is still on the wire
+			bool m_BulkReadDrained;		// or in m_BulkReadParser, not decoded yet
+			StatusPacketParser m_BulkReadParser;	// the per-tick bulk read response
+			double m_SensorTime;		// request time of the data in m_BulkReadData
+			int m_BulkReadTxLength;		// bytes of the bulk read request on the wire
+			unsigned char m_TxQueue[MAXNUM_TXQUEUE];
+			int m_TxQueueLength;
+			CommandQueue m_Commands;
+			ShadowTable m_Shadow;
+			PacketCapture *m_Capture;
 
-			int TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int priority);
+			// window: msec the answer is waited for at most, 0: the packet timeout
+			int TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int priority, double window = 0.0);
+			int WritePort(unsigned char *packet, int length);
+			int RxBulkReadPacket(unsigned char *txpacket, unsigned char *rxpacket, double start);
+			int GetBulkReadTimeout(unsigned char *txpacket);
+			void DrainBulkRead();
+			int DecodeFastBulkRead(unsigned char *txpacket, unsigned char *rxpacket, int rx_length, unsigned char *pending, bool feedback, double time);
+			void StoreBulkReadData(unsigned char *txpacket, int id, unsigned char *data, int error, bool feedback, double time);
+			void UpdateShadow(unsigned char *txpacket, unsigned char *rxpacket, double time);
+			void UpdateHealth(unsigned char *txpacket, unsigned char *pending);
+			int MakeProtocol2Packet(unsigned char *txpacket, unsigned char *packet);
+			int QueuePacket(unsigned char *txpacket);
+			int AppendPacket(unsigned char *txpacket, unsigned char *queue, int length);
+			double MakeBulkReadPacket(int dropped);
+			void ScheduleSlowFeedback();
+			double GetTxRxTime(unsigned char *txpacket);
+			static int GetStatisticsType(int instruction);
 			unsigned char CalculateChecksum(unsigned char *packet);
 
 		public:
 			bool DEBUG_PRINT;
 			BulkReadData m_BulkReadData[ID_BROADCAST];
-			int m_DelayedWord[10];
-			int m_DelayedAddress[10];
-			unsigned int m_DelayedWords;
-			bool m_bIncludeTempData;
 
 			ArbotixPro(PlatformArbotixPro *platform);
 			~ArbotixPro();
@@ -179,30 +345,112 @@ namespace Robot
 			bool ChangeBaud(int baud);
 			void Disconnect();
 			bool DXLPowerOn(bool state = true);
+			// Wait after switching the servo power on. A bus that is already
+			// powered is not switched again, so the wait is skipped.
+			void SetPowerOnSettleTime(int msec)		{ m_PowerOnSettleTime = msec; }
+			int GetPowerOnSettleTime()				{ return m_PowerOnSettleTime; }
+			// servo power off and on again, waiting the settle time after each
+			bool DXLPowerCycle();
+			double GetCurrentTime()					{ return m_Platform->GetCurrentTime(); }
+
+			// false for a plain USB2Dynamixel chain without power switch and sensors
+			void SetBoard(bool present)				{ m_HasBoard = present; m_FeedbackChanged = true; }
+			bool HasBoard()							{ return m_HasBoard; }
+			// joints on this chain, the only ones in the bulk read
+			void SetJointAttached(int id, bool attached);
+			bool IsJointAttached(int id)			{ return m_Attached[id]; }
+
+			// A joint missing QUARANTINE_MISSES bulk reads in a row leaves them until
+			// Reprobe() gets an answer from it.
+			bool IsJointQuarantined(int id)			{ return m_Quarantined[id]; }
+			bool HasQuarantined();
+			int Reprobe();
+			void ResetHealth();
+
+			// only re-frames the packets, so PROTOCOL_2 drives AX/MX tables alone
+			void SetProtocol(int protocol);
+			int GetProtocol()						{ return m_Protocol; }
 
 			// For board
 			int WriteByte(int address, int value, int *error);
 			int WriteWord(int address, int value, int *error);
-			void WriteWordDelayed(int address, int value);
 
-			// For actuators
-			int Ping(int id, int *error);
+			// For actuators. priority as for PlatformArbotixPro::AcquireBus(),
+			// 0 from the motion thread so that application traffic waits.
+			int Ping(int id, int *error, int priority = 2);
 			int ReadByte(int id, int address, int *pValue, int *error);
 			int ReadWord(int id, int address, int *pValue, int *error);
+			// Served from the shadow table when every byte was read or written
+			// within max_age msec (error is then 0), from the bus otherwise.
+			int ReadByte(int id, int address, int *pValue, int *error, double max_age);
+			int ReadWord(int id, int address, int *pValue, int *error, double max_age);
 			int ReadTable(int id, int start_addr, int end_addr, unsigned char *table, int *error);
-			int WriteByte(int id, int address, int value, int *error);
-			int WriteWord(int id, int address, int value, int *error);
+			int WriteByte(int id, int address, int value, int *error, int priority = 2);
+			int WriteWord(int id, int address, int value, int *error, int priority = 2);
 
 			// For motion control
 			int SyncWrite(int start_addr, int each_length, int number, int *pParam);
 
+			// Sent in order per ID with the next motion tick; false when the queue
+			// is full, GetDelayedOverflow() counts every write lost.
+			bool WriteByteDelayed(int address, int value);
+			bool WriteWordDelayed(int address, int value);
+			bool WriteByteDelayed(int id, int address, int value);
+			bool WriteWordDelayed(int id, int address, int value);
+			bool WriteDelayed(int number, int *id, int address, int length, int *value);
+			int QueueDelayedWrites();
+			unsigned int GetDelayedOverflow()		{ return m_Commands.GetOverflow(); }
+
 			void MakeBulkReadPacket();
 			int BulkRead();
 
+			// Queued SyncWrites go out in one port write on FlushSyncWrite(), with
+			// bulk_read followed by the request whose response CollectBulkRead() reads.
+			int QueueSyncWrite(int start_addr, int each_length, int number, int *pParam);
+			int FlushSyncWrite(bool bulk_read = false);
+			int CollectBulkRead();
+			bool IsBulkReadPending()				{ return m_BulkReadPending; }
+			double GetSensorTime()					{ return m_SensorTime; }
+
+			// Feedback set of the per-tick bulk read (FEEDBACK_xxx flags).
+			// The packet is rebuilt by the next BulkRead().
+			void SetFeedback(int fields);
+			void SetFeedback(int id, int fields);
+			int GetFeedback(int id)					{ return m_Feedback[id]; }
+			// fields added to the bulk read of a few joints per tick in turn, as many
+			// as fit in bytes (at least one) and the bus time left in the budget
+			void SetSlowFeedback(int fields, int bytes);
+			int GetSlowFeedback()					{ return m_SlowFeedback; }
+			// bus time one tick may take, the bulk read is rebuilt to fit
+			void SetRefreshTime(double msec)		{ m_RefreshTime = msec; m_FeedbackChanged = true; }
+			double GetRefreshTime()					{ return m_RefreshTime; }
+			void SetReturnDelayTime(int value)		{ m_ReturnDelayTime = value; }
+			double GetBulkReadTime()				{ return m_BulkReadTime; }
+			double GetTransferTime(int bytes);
+
+			// bulk reads start_addr ~ end_addr of the IDs whose shadow is older than max_age
+			int RefreshShadow(int number, int *id, int start_addr, int end_addr, double max_age);
+			ShadowTable* GetShadow()				{ return &m_Shadow; }
+
+			// Whole-robot reads and writes, one transaction each. ApplyPose() takes
+			// 0 for positions or slopes and a negative torque to leave it as it is.
+			int CapturePose(int number, int *id, int fields, Pose *pose);
+			int ApplyPose(int number, int *id, int *position, int *slope, int torque);
+
+			// Every byte written to and read from the port goes to the capture
+			// (0 to stop). Cheaper than DEBUG_PRINT, the timing stays as it is.
+			void SetCapture(PacketCapture *capture)	{ m_Capture = capture; m_RxParser.SetCapture(capture); m_BulkReadParser.SetCapture(capture); }
+			PacketCapture* GetCapture()				{ return m_Capture; }
+
+			// always-on bus counters and latency histograms
+			BusStatistics* GetStatistics()			{ return &m_Statistics; }
+
 			// Utility
 			static int MakeWord(int lowbyte, int highbyte);
 			static int GetLowByte(int word);
 			static int GetHighByte(int word);
+			// Protocol 2.0 CRC-16 (polynomial 0x8005)
+			static unsigned short UpdateCRC(unsigned short crc, const unsigned char *data, int length);
 	};
 }
 
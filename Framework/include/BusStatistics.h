@@ -0,0 +1,77 @@
+/*
+ *   BusStatistics.h
+ *
+ *   Per-instruction and per-device counters of the Dynamixel bus
+ *
+ */
+
+#ifndef _BUS_STATISTICS_H_
+#define _BUS_STATISTICS_H_
+
+#include <stdio.h>
+#include "Histogram.h"
+
+
+namespace Robot
+{
+	// Updated by ArbotixPro for every transaction while it holds the bus.
+	// Latency is the time the caller was blocked on the transaction, from
+	// the start of the write to the last status packet (msec).
+	class BusStatistics
+	{
+		public:
+			enum
+			{
+				PING,
+				READ,
+				WRITE,
+				SYNC_WRITE,
+				BULK_READ,
+				OTHER,
+				NUM_INSTRUCTION
+			};
+
+			enum
+			{
+				NUM_DEVICE = 254
+			};
+
+			class Entry
+			{
+				public:
+					unsigned int count;
+					unsigned int timeout;
+					unsigned int corrupt;
+					unsigned int fail;			// TX_FAIL or TX_CORRUPT
+					unsigned long tx_bytes;
+					unsigned long rx_bytes;
+					Histogram latency;
+
+					Entry();
+					void Reset();
+			};
+
+		private:
+			Entry m_Instruction[NUM_INSTRUCTION];
+			Entry m_Device[NUM_DEVICE];
+
+		public:
+			BusStatistics();
+
+			// result: ArbotixPro::SUCCESS, RX_TIMEOUT, ...
+			void Record(int instruction, int id, int result, int tx_bytes, int rx_bytes, double latency);
+			// one device of a bulk read
+			void RecordDevice(int id, int result, int rx_bytes);
+			void Reset();
+
+			Entry* GetInstruction(int instruction)	{ return &m_Instruction[instruction]; }
+			Entry* GetDevice(int id)				{ return &m_Device[id]; }
+			unsigned long GetTxBytes();
+			unsigned long GetRxBytes();
+
+			static const char* GetInstructionName(int instruction);
+			void Print(FILE *fp);
+	};
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ *   BusWorker.h
+ *
+ *   I/O thread doing the per-tick transactions of one Dynamixel chain
+ *
+ */
+
+#ifndef _BUS_WORKER_H_
+#define _BUS_WORKER_H_
+
+#include <pthread.h>
+#include "ArbotixPro.h"
+
+
+namespace Robot
+{
+	// The motion thread posts a job to the worker of every extra port, does
+	// the same job on its own port and then waits for the workers, so the
+	// chains are busy at the same time within one tick.
+	class BusWorker
+	{
+		public:
+			enum
+			{
+				JOB_COLLECT			= 0x01,	// CollectBulkRead()
+				JOB_FLUSH			= 0x02,	// FlushSyncWrite()
+				JOB_FLUSH_BULK_READ	= 0x04,	// FlushSyncWrite(true)
+				JOB_BULK_READ		= 0x08	// BulkRead()
+			};
+
+		private:
+			ArbotixPro *m_ArbotixPro;
+			pthread_t m_Thread;
+			pthread_mutex_t m_Mutex;
+			pthread_cond_t m_Cond;
+			int m_Job;
+			bool m_Busy;
+			bool m_Running;
+
+			static void* ThreadProc(void *param);
+
+		public:
+			BusWorker(ArbotixPro *arbotixpro);
+			~BusWorker();
+
+			bool Start();
+			void Stop();
+
+			void Post(int job);
+			void Wait();
+
+			ArbotixPro* GetArbotixPro()		{ return m_ArbotixPro; }
+			pthread_t GetThread()			{ return m_Thread; }
+			bool IsRunning()				{ return m_Running; }
+
+			// does the job on the calling thread
+			static void Run(ArbotixPro *arbotixpro, int job);
+	};
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ *   CommandQueue.h
+ *
+ *   Bounded lock-free queue of control table writes
+ *
+ */
+
+#ifndef _COMMAND_QUEUE_H_
+#define _COMMAND_QUEUE_H_
+
+
+namespace Robot
+{
+	// Any number of threads push, only the motion thread pops.
+	// Every cell carries a sequence number telling whether it is free for
+	// the producer of a given position or holds a command for the consumer,
+	// so neither side ever blocks. A push into a full queue fails and is
+	// counted instead of overwriting a pending command.
+	class CommandQueue
+	{
+		public:
+			enum
+			{
+				CAPACITY = 64 // must be a power of two
+			};
+
+			class Command
+			{
+				public:
+					int id;
+					int address;
+					int length;		// 1 or 2 bytes
+					int value;
+			};
+
+		private:
+			class Cell
+			{
+				public:
+					volatile unsigned int sequence;
+					Command command;
+			};
+
+			Cell m_Cell[CAPACITY];
+			volatile unsigned int m_Head;		// next position to push
+			unsigned int m_Tail;				// next position to pop
+			volatile unsigned int m_Overflow;
+
+		public:
+			CommandQueue();
+
+			bool Push(int id, int address, int length, int value);
+			bool Pop(Command *command);
+
+			// commands lost to a full queue, or given up by the consumer
+			unsigned int GetOverflow()		{ return m_Overflow; }
+			void AddOverflow(unsigned int count)	{ __sync_fetch_and_add(&m_Overflow, count); }
+			void ResetOverflow()			{ m_Overflow = 0; }
+	};
+}
+
+#endif
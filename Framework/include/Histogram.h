@@ -0,0 +1,52 @@
+/*
+ *   Histogram.h
+ *
+ *   Fixed-size histogram of timing samples
+ *
+ */
+
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+
+namespace Robot
+{
+	// Samples are counted in NUM_BUCKETS buckets of equal width; the last
+	// bucket also takes every sample beyond the range. Adding a sample does
+	// not allocate or lock, so it can be done on the motion thread.
+	class Histogram
+	{
+		public:
+			enum
+			{
+				NUM_BUCKETS = 64
+			};
+
+		private:
+			double m_BucketWidth;
+			unsigned int m_Bucket[NUM_BUCKETS];
+			unsigned int m_Count;
+			double m_Sum;
+			double m_Min;
+			double m_Max;
+
+		public:
+			Histogram(double bucket_width = 0.1);
+
+			void Add(double value);
+			void Reset();
+
+			void SetBucketWidth(double width)			{ m_BucketWidth = width; Reset(); }
+			double GetBucketWidth()						{ return m_BucketWidth; }
+			unsigned int GetBucket(int index)			{ return m_Bucket[index]; }
+			unsigned int GetCount()						{ return m_Count; }
+			double GetMin()								{ return m_Min; }
+			double GetMax()								{ return m_Max; }
+			double GetMean();
+			// upper edge of the bucket holding the given fraction (0.0 ~ 1.0) of the
+			// samples, never above the largest sample
+			double GetPercentile(double fraction);
+	};
+}
+
+#endif
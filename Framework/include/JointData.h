@@ -53,6 +53,13 @@ namespace Robot
 			{
 				TEMP_DEFAULT	= 0
 			};
+
+			enum
+			{
+				CHANGED_VALUE	= 1,
+				CHANGED_SLOPE	= 2,
+				CHANGED_ALL		= CHANGED_VALUE | CHANGED_SLOPE
+			};
 			enum
 			{
 				P_GAIN_DEFAULT      = 32,
@@ -64,6 +71,7 @@ namespace Robot
 
 		protected:
 			bool m_Enable[NUMBER_OF_JOINTS];
+			unsigned int m_EnableMask;		// bit id set when enabled
 			int m_Value[NUMBER_OF_JOINTS];
 			double m_Angle[NUMBER_OF_JOINTS];
 			int m_CWSlope[NUMBER_OF_JOINTS];
@@ -72,6 +80,11 @@ namespace Robot
 			int m_IGain[NUMBER_OF_JOINTS];
 			int m_DGain[NUMBER_OF_JOINTS];
 			int m_Temp[NUMBER_OF_JOINTS];
+			int m_PresentPosition[NUMBER_OF_JOINTS];
+			int m_PresentSpeed[NUMBER_OF_JOINTS];
+			int m_PresentLoad[NUMBER_OF_JOINTS];
+			int m_Voltage[NUMBER_OF_JOINTS];
+			int m_Changed[NUMBER_OF_JOINTS];
 
 		public:
 			JointData();
@@ -98,6 +111,7 @@ namespace Robot
 			void SetEnableBody(bool enable);
 			void SetEnableBody(bool enable, bool exclusive);
 			bool GetEnable(int id);
+			unsigned int GetEnableMask()					{ return m_EnableMask; }
 
 			void SetValue(int id, int value);
 			int GetValue(int id);
@@ -121,8 +135,23 @@ namespace Robot
 			void SetDGain(int id, int dgain) { m_DGain[id] = dgain; }
 			int  GetDGain(int id)            { return m_DGain[id]; }
 
+			// CHANGED_xxx flags of the fields modified since the last ClearChanged()
+			int GetChanged(int id)							{ return m_Changed[id]; }
+			void SetChanged(int id, int flags)				{ m_Changed[id] |= flags; }
+			void ClearChanged(int id)						{ m_Changed[id] = 0; }
+
 			int GetTemp(int id)									{ return m_Temp[id]; }
 			void SetTemp(int id, int value)			{ m_Temp[id] = value; }
+
+			// feedback from the per-tick bulk read (see ArbotixPro::SetFeedback)
+			int GetPresentPosition(int id)					{ return m_PresentPosition[id]; }
+			void SetPresentPosition(int id, int value)	{ m_PresentPosition[id] = value; }
+			int GetPresentSpeed(int id)						{ return m_PresentSpeed[id]; }
+			void SetPresentSpeed(int id, int value)		{ m_PresentSpeed[id] = value; }
+			int GetPresentLoad(int id)						{ return m_PresentLoad[id]; }
+			void SetPresentLoad(int id, int value)		{ m_PresentLoad[id] = value; }
+			int GetVoltage(int id)								{ return m_Voltage[id]; }
+			void SetVoltage(int id, int value)			{ m_Voltage[id] = value; }
 	};
 }
 
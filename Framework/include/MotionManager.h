@@ -8,25 +8,69 @@
 #ifndef _MOTION_MANGER_H_
 #define _MOTION_MANGER_H_
 
-#include <list>
-#include <fstream>
 #include <iostream>
+#include <pthread.h>
+#include <semaphore.h>
 #include "MotionStatus.h"
 #include "MotionModule.h"
 #include "ArbotixPro.h"
+#include "BusWorker.h"
 #include "minIni.h"
 #include "AngleEstimator.h"
+#include "ServoResponse.h"
+#include "TickStatistics.h"
 
 #define OFFSET_SECTION "Offset"
+#define BOOT_SECTION "Boot"
+#define PORT_SECTION "Port Map"
+#define TIMER_SECTION "Timer"
 #define INVALID_VALUE   -1024.0
 
 namespace Robot
 {
 	class MotionManager
 	{
+		public:
+			enum
+			{
+				MAX_PORTS = 4,
+				MAX_MODULES = 8,
+				MAXNUM_LOG_RECORD = 37500	// 5 minutes at 8msec
+			};
+
 		private:
+			// one tick of the log, written out by StopLogging()
+			struct LogRecord
+			{
+				short goal[JointData::NUMBER_OF_JOINTS];
+				short present[JointData::NUMBER_OF_JOINTS];
+				short sensor[8];	// gyro FB, RL, accel FB, RL, FSR L x, y, R x, y
+			};
+
+			// a joint with an owner, see Compose()
+			struct JointSlot
+			{
+				int id;
+				MotionModule *owner;
+				MotionModule *from;		// the previous owner while fading, 0: from hold
+				int hold;				// goal when the fade started
+				double time;			// msec into the fade
+				double length;			// msec, 0: not fading
+			};
+
 			static MotionManager* m_UniqueInstance;
-			std::list<MotionModule*> m_Modules;
+			MotionModule* m_Modules[MAX_MODULES];
+			unsigned int m_ModuleMask[MAX_MODULES];	// enables the owners were assigned from
+			int m_ModuleBlend[MAX_MODULES];			// msec into the module, -1: m_BlendTime
+			int m_NumModules;
+
+			JointSlot m_Slot[JointData::NUMBER_OF_JOINTS];
+			int m_NumSlots;
+			int m_SlotOf[JointData::NUMBER_OF_JOINTS];		// -1: no owner
+			MotionModule* volatile m_Owner[JointData::NUMBER_OF_JOINTS];
+			int m_JointBlend[JointData::NUMBER_OF_JOINTS];	// msec of the next handover, -1: the module's
+			int m_BlendTime;
+			volatile bool m_OwnersChanged;
 			ArbotixPro *m_ArbotixPro;
 			bool m_ProcessEnable;
 			bool m_Enabled;
@@ -34,24 +78,71 @@ namespace Robot
 			int m_RLGyroCenter;
 			int m_CalibrationStatus;
 
-			bool m_IsRunning;
+			volatile bool m_IsRunning;
 			bool m_IsThreadRunning;
-			bool m_IsLogging;
+			volatile bool m_IsLogging;
+			bool m_Pipelined;
+			int m_RefreshCounter;
+			int m_SentOffset[JointData::NUMBER_OF_JOINTS];
+			int m_SentValue[JointData::NUMBER_OF_JOINTS];
 
-			std::ofstream m_LogFileStream;
+			ServoResponse m_Response;
+			bool m_Compensate;
+
+			TickStatistics m_TickStatistics;
+
+			LogRecord *m_LogRecord;		// MAXNUM_LOG_RECORD, taken by the first StartLogging()
+			volatile int m_LogCount;
+			unsigned int m_LogDropped;
+			char m_LogFile[32];
 
 			AngleEstimator m_angleEstimator;
 			bool m_fadeIn;
 			int m_torque_count;
+			int m_FadeInStart;
+			int m_FadeInStep;
+			int m_FadeInTime;
+
+			double m_Period;			// msec
+			double m_IdlePeriod;		// msec, 0: the period is kept while idle
+			double m_IdleTime;			// msec without a goal change
+			bool m_Moved;				// a goal changed this tick
+
+			bool m_ServoMap[JointData::NUMBER_OF_JOINTS];	// joints found by the last run
+			int m_BootTimeout;								// msec
+
+			BusWorker *m_Worker[MAX_PORTS];		// port 0 is m_ArbotixPro, done on the motion thread
+			int m_NumPorts;
+			int m_JointPort[JointData::NUMBER_OF_JOINTS];
+			bool m_Quarantined[JointData::NUMBER_OF_JOINTS];
 
 			FILE* m_voltageLog;
 
 			unsigned int m_torqueAdaptionCounter;
 			double m_voltageAdaptionFactor;
 
+			// the reprobes and the poweroff on low voltage are left to this thread
+			pthread_t m_ServiceThread;
+			sem_t m_Shutdown;
+			bool m_ServiceReady;
+
 			MotionManager();
 
+			static void *ServiceProc(void *param);
+
 			void adaptTorqueToVoltage();
+			void QueueJointSyncWrite();
+			void QueueJointSyncWrite(int port, bool refresh);
+			void UpdateFeedback();
+			void UpdateHealth();
+			bool ProbeJoints(int number, int *id, bool *present);
+			void AttachJoints();
+			bool IsModule(MotionModule *module);
+			void AssignOwners();
+			void Compose();
+			void RunPorts(int job);
+			void WriteWordAllPorts(int address, int value);	// at motion priority
+			bool DiscoverJoints();
 
 		protected:
 
@@ -64,19 +155,73 @@ namespace Robot
 			static MotionManager* GetInstance() { return m_UniqueInstance; }
 
 			bool Initialize(ArbotixPro *arbotixpro, bool fadeIn = true);
+			// Checks the servo map in [Boot] with one bulk read before the other IDs.
+			// Also takes settle_time, fade_in_torque and fade_in_time (msec).
+			bool Initialize(ArbotixPro *arbotixpro, minIni *ini, bool fadeIn = true);
+			// Power-cycles every port, clears the quarantine and finds the joints again.
 			bool Reinitialize();
 			void Process();
 			void SetEnable(bool enable);
 			bool GetEnable()				{ return m_Enabled; }
-			void AddModule(MotionModule *module);
+			// up to MAX_MODULES, false when there is no room
+			bool AddModule(MotionModule *module);
 			void RemoveModule(MotionModule *module);
 
+			// A joint belongs to the last added module enabling it and fades to a new
+			// owner over the blend time (msec, 0: at once, "blend_time" in [Timer]).
+			void SetBlendTime(int msec)			{ m_BlendTime = msec; }
+			int GetBlendTime()					{ return m_BlendTime; }
+			void SetBlendTime(MotionModule *module, int msec);	// -1: the default
+			// enables the joint on the module alone, msec -1: the module's blend time
+			void SetJointOwner(int id, MotionModule *module, int msec = -1);
+			MotionModule* GetJointOwner(int id)	{ return m_Owner[id]; }
+
 			void ResetGyroCalibration() { m_CalibrationStatus = 0; m_FBGyroCenter = 512; m_RLGyroCenter = 512; }
 			int GetCalibrationStatus() { return m_CalibrationStatus; }
 			void SetJointDisable(int index);
-
+			// A joint that keeps missing the bulk read is quarantined and pinged
+			// every 100msec between the ticks until it answers again.
+			bool IsJointQuarantined(int id)	{ return m_Quarantined[id]; }
+			// torque limit ramp from torque to full in msec
+			void SetFadeIn(int torque, int msec);
+
+			// Another chain with its own I/O thread, added before Initialize().
+			// Joints are on port 0 unless mapped (ID_xx in [Port Map]).
+			int AddPort(ArbotixPro *arbotixpro);
+			void SetJointPort(int id, int port);
+			int GetJointPort(int id)		{ return m_JointPort[id]; }
+			int GetNumPorts()				{ return m_NumPorts; }
+			ArbotixPro* GetPort(int port)	{ return (port == 0) ? m_ArbotixPro : m_Worker[port]->GetArbotixPro(); }
+			// I/O thread of an extra port (1 ~ GetNumPorts() - 1)
+			BusWorker* GetWorker(int port)	{ return m_Worker[port]; }
+
+			// goals and bulk read request in one write, the response read next tick
+			void SetPipelined(bool enable)	{ m_Pipelined = enable; }
+			bool GetPipelined()				{ return m_Pipelined; }
+
+			// goals led by each joint's identified response ("compensate" in [Servo Response])
+			void SetCompensation(bool enable)	{ m_Compensate = enable; m_RefreshCounter = 1; }
+			bool GetCompensation()				{ return m_Compensate; }
+			ServoResponse* GetServoResponse()	{ return &m_Response; }
+
+			// Tick period (msec, TIME_UNIT by default), "period" in [Timer], from
+			// the next tick on; the bus work of a tick may take 3/4 of it.
+			void SetPeriod(double msec);
+			double GetPeriod()					{ return m_Period; }
+			// Longer period once no goal changed for a second, left at the
+			// first change ("idle_period" in [Timer], 0: off)
+			void SetIdlePeriod(double msec)		{ m_IdlePeriod = msec; }
+			double GetIdlePeriod()				{ return m_IdlePeriod; }
+			bool IsIdle()						{ return MotionModule::PERIOD != m_Period; }
+			double GetTickPeriod()				{ return MotionModule::PERIOD; }
+
+			// phase timing of the ticks, see TickStatistics
+			TickStatistics* GetTickStatistics()	{ return &m_TickStatistics; }
+
+			// every tick kept in memory, written to Logs/LogN.csv by StopLogging()
 			void StartLogging();
 			void StopLogging();
+			unsigned int GetLogDropped()		{ return m_LogDropped; }
 
 			void LoadINISettings(minIni* ini);
 			void LoadINISettings(minIni* ini, const std::string &section);
@@ -21,7 +21,8 @@ namespace Robot
 		public:
 			JointData m_Joint;
 
-			static const int TIME_UNIT = 8; //msec
+			static const int TIME_UNIT = 8; //msec, default tick period
+			static double PERIOD;   //!< msec since the previous tick, set by MotionManager
 
 			virtual void Initialize() = 0;
 			virtual void Process() = 0;
@@ -20,9 +20,33 @@ namespace Robot
 		FORWARD     = 1
 	};
 
+	// The fields of MotionStatus as they were at the end of one tick
+	class MotionSnapshot
+	{
+		public:
+			unsigned int TICK;			//!< number of the tick, 0 before the first one
+			JointData m_CurrentJoints;
+			double FB_GYRO;
+			double RL_GYRO;
+			int FB_ACCEL;
+			int RL_ACCEL;
+			double ANGLE_PITCH;
+			double ANGLE_ROLL;
+			int BUTTON;
+			int FALLEN;
+			double SENSOR_TIME;
+			double SLOW_SENSOR_TIME[JointData::NUMBER_OF_JOINTS];
+
+			MotionSnapshot();
+	};
+
 	class MotionStatus
 	{
 		private:
+			// Published by the motion thread alone, into the buffer readers are
+			// not directed to; odd while a snapshot is being written.
+			static MotionSnapshot m_Snapshot[2];
+			static volatile unsigned int m_Sequence;
 
 		public:
 			static const int FALLEN_F_LIMIT     = 440;
@@ -41,6 +65,15 @@ namespace Robot
 
 			static int BUTTON;
 			static int FALLEN;
+
+			static double SENSOR_TIME;  //!< monotonic msec the sensor and joint feedback were requested
+			static double SLOW_SENSOR_TIME[JointData::NUMBER_OF_JOINTS];  //!< monotonic msec the load, voltage and temperature of a joint were last requested (0: never)
+
+			// The fields above are written one by one during the tick; threads
+			// other than the motion thread take them all from one tick with
+			// Snapshot(), which retries instead of blocking the publisher.
+			static void Publish();
+			static MotionSnapshot Snapshot();
 	};
 }
 
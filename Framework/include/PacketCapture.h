@@ -0,0 +1,64 @@
+/*
+ *   PacketCapture.h
+ *
+ *   Lock-free ring of the raw bytes sent and received on the Dynamixel bus
+ *
+ */
+
+#ifndef _PACKET_CAPTURE_H_
+#define _PACKET_CAPTURE_H_
+
+
+namespace Robot
+{
+	// ArbotixPro adds every port write and every port read while it holds
+	// the bus, a drain thread takes whole records out. One producer and one
+	// consumer: neither side locks or waits, a record not fitting in the
+	// ring is dropped and counted. Records are kept in the trace file format
+	// so they are written out as they are:
+	//
+	//   time (8, nsec, monotonic)  length (2)  direction (1)  protocol (1)  data
+	//
+	// little-endian, after a file header of MAGIC and VERSION (4).
+	class PacketCapture
+	{
+		public:
+			enum
+			{
+				RING_SIZE		= 1 << 20,	// must be a power of two
+				HEADER_SIZE		= 12,
+				FILE_HEADER_SIZE = 12,
+				VERSION			= 1
+			};
+
+			enum
+			{
+				DIRECTION_TX,
+				DIRECTION_RX
+			};
+
+			static const char MAGIC[8];
+
+		private:
+			unsigned char m_Ring[RING_SIZE];
+			volatile unsigned int m_Head;		// written by the producer
+			volatile unsigned int m_Tail;		// written by the consumer
+			volatile unsigned int m_Dropped;
+
+			void Copy(unsigned int position, const unsigned char *data, int length);
+
+		public:
+			PacketCapture();
+			virtual ~PacketCapture();
+
+			// time: msec as given by PlatformArbotixPro::GetCurrentTime()
+			void Add(int direction, int protocol, double time, const unsigned char *data, int length);
+			// whole records only, returns the bytes copied
+			int Drain(unsigned char *buffer, int size);
+
+			unsigned int GetDropped()			{ return m_Dropped; }
+			static void MakeFileHeader(unsigned char *header);
+	};
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ *   ServoResponse.h
+ *
+ *   Per-joint delay and time constant from the SyncWrite of a goal to the motion
+ *
+ */
+
+#ifndef _SERVO_RESPONSE_H_
+#define _SERVO_RESPONSE_H_
+
+#include <string>
+#include "JointData.h"
+
+#define RESPONSE_SECTION "Servo Response"
+
+class minIni;
+
+namespace Robot
+{
+	// A joint is taken as a dead time followed by a first order lag, fitted
+	// from the present positions after a goal step. Lead() gives the goal
+	// extrapolated along its rate by the dead time plus the time constant,
+	// so a moving trajectory is sent that much earlier.
+	class ServoResponse
+	{
+		private:
+			double m_Delay[JointData::NUMBER_OF_JOINTS];	// msec
+			double m_Tau[JointData::NUMBER_OF_JOINTS];		// msec
+			int m_LastGoal[JointData::NUMBER_OF_JOINTS];
+			bool m_HasLast[JointData::NUMBER_OF_JOINTS];
+
+		public:
+			ServoResponse();
+
+			// time: msec since the goal was sent, position: present position.
+			// false when the joint did not get past 63% of the step.
+			bool Fit(int id, int number, double *time, int *position, int start, int goal);
+			int Lead(int id, int goal);
+			// the next Lead() of the joint starts from rest
+			void Reset(int id)								{ m_HasLast[id] = false; }
+
+			double GetDelay(int id)							{ return m_Delay[id]; }
+			double GetTau(int id)							{ return m_Tau[id]; }
+			void Set(int id, double delay, double tau)		{ m_Delay[id] = delay; m_Tau[id] = tau; }
+
+			void LoadINISettings(minIni *ini, const std::string &section = RESPONSE_SECTION);
+			void SaveINISettings(minIni *ini, const std::string &section = RESPONSE_SECTION);
+	};
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ *   ShadowTable.h
+ *
+ *   Per-device copy of the control tables with the age of every byte
+ *
+ */
+
+#ifndef _SHADOW_TABLE_H_
+#define _SHADOW_TABLE_H_
+
+
+namespace Robot
+{
+	// Filled by ArbotixPro from every read, bulk read and write that goes
+	// over the bus. Each device is guarded by a sequence lock: writers take
+	// it with a compare-and-swap, readers never block and only retry when a
+	// writer was busy with the same device. A device takes written values
+	// only once it has answered a read, so writes to an absent ID never
+	// make it look present.
+	class ShadowTable
+	{
+		public:
+			enum
+			{
+				NUM_DEVICE		= 254,
+				NUM_ADDRESS		= 256
+			};
+
+		private:
+			class Device
+			{
+				public:
+					volatile unsigned int sequence;		// odd while being written
+					bool present;
+					unsigned char table[NUM_ADDRESS];
+					double time[NUM_ADDRESS];			// msec, 0 when never read
+			};
+
+			Device m_Device[NUM_DEVICE];
+
+			void Lock(Device *dev);
+			void Unlock(Device *dev);
+			void Store(int id, int address, const unsigned char *data, int length, double time, bool answered);
+
+		public:
+			ShadowTable();
+
+			// values read from the device
+			void Update(int id, int address, const unsigned char *data, int length, double time);
+			// values written to the device (write-through)
+			void Write(int id, int address, const unsigned char *data, int length, double time);
+			void Invalidate(int id);
+			void Reset();
+
+			// true when every byte was read or written at or after 'since'
+			bool Read(int id, int address, unsigned char *data, int length, double since);
+			bool IsPresent(int id);
+	};
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ *   TickStatistics.h
+ *
+ *   Per-phase timing of the motion tick
+ *
+ */
+
+#ifndef _TICK_STATISTICS_H_
+#define _TICK_STATISTICS_H_
+
+#include <stdio.h>
+#include "Histogram.h"
+
+
+namespace Robot
+{
+	// Filled on the motion thread: the wake-up latency and the overruns by
+	// the timer, the phases of MotionManager::Process() by the manager
+	// (msec). COMPUTE is what the bus phases leave of TOTAL.
+	class TickStatistics
+	{
+		public:
+			enum
+			{
+				WAKEUP,
+				COMPUTE,
+				SYNC_WRITE,
+				BULK_READ,
+				TOTAL,
+				NUM_PHASE
+			};
+
+		private:
+			Histogram m_Phase[NUM_PHASE];
+			double m_Last[NUM_PHASE];
+			double m_Period;
+			unsigned int m_Overruns;	// ticks that ran into the next period
+			unsigned int m_Skipped;		// periods dropped by those ticks
+
+		public:
+			TickStatistics();
+
+			void Record(int phase, double msec);
+			void RecordOverrun(int skipped);
+			void Reset();
+
+			// the bucket width of the phases follows the tick period
+			void SetPeriod(double msec);
+			double GetPeriod()						{ return m_Period; }
+
+			Histogram* GetPhase(int phase)			{ return &m_Phase[phase]; }
+			double GetLast(int phase)				{ return m_Last[phase]; }
+			unsigned int GetTicks()					{ return m_Phase[TOTAL].GetCount(); }
+			unsigned int GetOverruns()				{ return m_Overruns; }
+			unsigned int GetSkipped()				{ return m_Skipped; }
+
+			static const char* GetPhaseName(int phase);
+			void Print(FILE *fp);
+	};
+}
+
+#endif
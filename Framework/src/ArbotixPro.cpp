@@ -9,6 +9,7 @@
 #include "ArbotixPro.h"
 #include "MotionStatus.h"
 #include <stdlib.h>
+#include <string.h>
 
 using namespace Robot;
 
@@ -28,6 +29,49 @@ using namespace Robot;
 #define INST_RESET			(6)
 #define INST_SYNC_WRITE		(131)   // 0x83
 #define INST_BULK_READ      (146)   // 0x92
+#define INST_FAST_BULK_READ (154)   // 0x9A, Protocol 2.0
+#define INST_STATUS         (85)    // 0x55, Protocol 2.0
+
+// Protocol 2.0: FF FF FD 00 ID LEN_L LEN_H INST PARAM... CRC_L CRC_H
+#define HEADER_LENGTH2		(7)
+
+static const unsigned char Header2[4] = { 0xFF, 0xFF, 0xFD, 0x00 };
+
+static const unsigned short CRCTable[256] =
+{
+	0x0000, 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
+	0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027, 0x0022,
+	0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D, 0x8077, 0x0072,
+	0x0050, 0x8055, 0x805F, 0x005A, 0x804B, 0x004E, 0x0044, 0x8041,
+	0x80C3, 0x00C6, 0x00CC, 0x80C9, 0x00D8, 0x80DD, 0x80D7, 0x00D2,
+	0x00F0, 0x80F5, 0x80FF, 0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1,
+	0x00A0, 0x80A5, 0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1,
+	0x8093, 0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
+	0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197, 0x0192,
+	0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE, 0x01A4, 0x81A1,
+	0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB, 0x01FE, 0x01F4, 0x81F1,
+	0x81D3, 0x01D6, 0x01DC, 0x81D9, 0x01C8, 0x81CD, 0x81C7, 0x01C2,
+	0x0140, 0x8145, 0x814F, 0x014A, 0x815B, 0x015E, 0x0154, 0x8151,
+	0x8173, 0x0176, 0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162,
+	0x8123, 0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
+	0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104, 0x8101,
+	0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D, 0x8317, 0x0312,
+	0x0330, 0x8335, 0x833F, 0x033A, 0x832B, 0x032E, 0x0324, 0x8321,
+	0x0360, 0x8365, 0x836F, 0x036A, 0x837B, 0x037E, 0x0374, 0x8371,
+	0x8353, 0x0356, 0x035C, 0x8359, 0x0348, 0x834D, 0x8347, 0x0342,
+	0x03C0, 0x83C5, 0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1,
+	0x83F3, 0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
+	0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7, 0x03B2,
+	0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E, 0x0384, 0x8381,
+	0x0280, 0x8285, 0x828F, 0x028A, 0x829B, 0x029E, 0x0294, 0x8291,
+	0x82B3, 0x02B6, 0x02BC, 0x82B9, 0x02A8, 0x82AD, 0x82A7, 0x02A2,
+	0x82E3, 0x02E6, 0x02EC, 0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2,
+	0x02D0, 0x82D5, 0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1,
+	0x8243, 0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
+	0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264, 0x8261,
+	0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E, 0x0234, 0x8231,
+	0x8213, 0x0216, 0x021C, 0x8219, 0x0208, 0x820D, 0x8207, 0x0202
+};
 
 
 BulkReadData::BulkReadData() :
@@ -35,13 +79,18 @@ BulkReadData::BulkReadData() :
 	length(0),
 	error(-1)
 {
-	for (int i = 0; i < AXDXL::MAXNUM_ADDRESS; i++)
-		table[i] = 0;
+	for (int i = 0; i < MAXNUM_TABLE; i++)
+		{
+			table[i] = 0;
+			received[i] = false;
+		}
 }
 
 int BulkReadData::ReadByte(int address)
 {
-	if (address >= start_address && address < (start_address + length))
+	if (address < 0 || address >= MAXNUM_TABLE)
+		return 0;
+	if ((address >= start_address && address < (start_address + length)) || received[address] == true)
 		return (int)table[address];
 
 	return 0;
@@ -49,20 +98,312 @@ int BulkReadData::ReadByte(int address)
 
 int BulkReadData::ReadWord(int address)
 {
-	if (address >= start_address && address < (start_address + length))
+	if (address < 0 || address + 1 >= MAXNUM_TABLE)
+		return 0;
+	if ((address >= start_address && address < (start_address + length)) || (received[address] == true && received[address + 1] == true))
 		return ArbotixPro::MakeWord(table[address], table[address + 1]);
 
 	return 0;
 }
 
+bool BulkReadData::Contains(int address, int num)
+{
+	return (error == 0 && address >= start_address && (address + num) <= (start_address + length));
+}
+
+
+Pose::Pose()
+{
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		{
+			valid[id] = false;
+			torque[id] = 0;
+			slope[id] = 0;
+			goal[id] = 0;
+			position[id] = 0;
+			speed[id] = 0;
+			load[id] = 0;
+			voltage[id] = 0;
+			temperature[id] = 0;
+		}
+}
+
+
+StatusPacketParser::StatusPacketParser()
+{
+	m_Protocol = ArbotixPro::PROTOCOL_1;
+	m_Capture = 0;
+	Reset();
+}
+
+void StatusPacketParser::Reset()
+{
+	m_Head = 0;
+	m_Start = 0;
+	m_Pos = 0;
+	m_Received = 0;
+	m_State = WAIT_HEADER1;
+	m_Index = 0;
+	m_Checksum = 0;
+	m_Length = 0;
+	m_Output = 0;
+	m_Stuffing = 0;
+	m_Instruction = 0;
+	m_CRC = 0;
+	m_PacketLength = 0;
+}
+
+int StatusPacketParser::Fill(PlatformArbotixPro *platform, bool debug)
+{
+	// never overwrite the packet that is still being decoded
+	unsigned int space = RING_SIZE - (m_Head - m_Start);
+	unsigned int offset = m_Head & (RING_SIZE - 1);
+
+	if (space > RING_SIZE - offset)
+		space = RING_SIZE - offset;
+	if (space == 0)
+		return 0;
+
+	int length = platform->ReadPort(&m_Ring[offset], space);
+	if (length <= 0)
+		return 0;
+
+	if (m_Capture != 0)
+		m_Capture->Add(PacketCapture::DIRECTION_RX, m_Protocol, platform->GetCurrentTime(), &m_Ring[offset], length);
+
+	if (debug == true)
+		{
+			for (int n = 0; n < length; n++)
+				fprintf(stderr, "%.2X ", m_Ring[offset + n]);
+		}
+
+	m_Head += length;
+	m_Received += length;
+
+	return length;
+}
+
+int StatusPacketParser::Parse(unsigned char *packet)
+{
+	while (m_Pos != m_Head)
+		{
+			unsigned char data = m_Ring[m_Pos & (RING_SIZE - 1)];
+			m_Pos++;
+
+			switch (m_State)
+				{
+				case WAIT_HEADER1:
+					m_Start = m_Pos - 1;
+					if (data == 0xFF)
+						m_State = WAIT_HEADER2;
+					break;
+
+				case WAIT_HEADER2:
+					if (data == 0xFF)
+						m_State = (m_Protocol == ArbotixPro::PROTOCOL_2) ? WAIT_HEADER3 : WAIT_ID;
+					else
+						{
+							m_Start = m_Pos;
+							m_State = WAIT_HEADER1;
+						}
+					break;
+
+				case WAIT_HEADER3:
+					if (data == 0xFD)
+						m_State = WAIT_RESERVED;
+					else if (data == 0xFF)
+						m_Start++;
+					else
+						{
+							m_Start = m_Pos;
+							m_State = WAIT_HEADER1;
+						}
+					break;
+
+				case WAIT_RESERVED:
+					if (data == 0x00)
+						m_State = WAIT_ID;
+					else
+						{
+							m_Pos = m_Start + 1;
+							m_State = WAIT_HEADER1;
+						}
+					break;
+
+				case WAIT_ID:
+					if (m_Protocol == ArbotixPro::PROTOCOL_2)
+						{
+							packet[ID] = data;
+							m_CRC = ArbotixPro::UpdateCRC(0, Header2, 4);
+							m_CRC = ArbotixPro::UpdateCRC(m_CRC, &data, 1);
+							m_State = WAIT_LENGTH;
+							break;
+						}
+					if (data == 0xFF)
+						{
+							// more than two 0xFF, the header starts one byte later
+							m_Start++;
+							break;
+						}
+					packet[ID] = data;
+					m_Checksum = data;
+					m_State = WAIT_LENGTH;
+					break;
+
+				case WAIT_LENGTH:
+					if (m_Protocol == ArbotixPro::PROTOCOL_2)
+						{
+							m_Length = data;
+							m_CRC = ArbotixPro::UpdateCRC(m_CRC, &data, 1);
+							m_State = WAIT_LENGTH_H;
+							break;
+						}
+					if (data < 2)
+						{
+							// impossible length, resync right after the bogus header
+							m_Pos = m_Start + 1;
+							m_State = WAIT_HEADER1;
+							break;
+						}
+					packet[LENGTH] = data;
+					m_Checksum += data;
+					m_Index = 0;
+					m_State = WAIT_DATA;
+					break;
+
+				case WAIT_LENGTH_H:
+					m_Length |= data << 8;
+					// instruction, error and CRC at least
+					if (m_Length < 4 || m_Length > MAXNUM_RXPARAM + 4)
+						{
+							m_Pos = m_Start + 1;
+							m_State = WAIT_HEADER1;
+							break;
+						}
+					m_CRC = ArbotixPro::UpdateCRC(m_CRC, &data, 1);
+					m_Index = 0;
+					m_Output = 0;
+					m_Stuffing = 0;
+					m_State = WAIT_DATA;
+					break;
+
+				case WAIT_DATA:
+					if (m_Protocol == ArbotixPro::PROTOCOL_2)
+						{
+							m_Index++;
+							if (m_Index <= m_Length - 2)
+								{
+									m_CRC = ArbotixPro::UpdateCRC(m_CRC, &data, 1);
+
+									// 0xFD after 0xFF 0xFF 0xFD is stuffing
+									if (m_Stuffing == 3 && data == 0xFD)
+										{
+											m_Stuffing = 0;
+											break;
+										}
+									if (data == 0xFF)
+										m_Stuffing = (m_Stuffing == 1 || m_Stuffing == 2) ? 2 : 1;
+									else if (data == 0xFD && m_Stuffing == 2)
+										m_Stuffing = 3;
+									else
+										m_Stuffing = 0;
+
+									if (m_Output == 0)
+										m_Instruction = data;
+									else
+										packet[ERRBIT + m_Output - 1] = data;
+									m_Output++;
+									break;
+								}
+							if (m_Index == m_Length - 1)
+								{
+									m_Checksum = data;
+									break;
+								}
+
+							m_State = WAIT_HEADER1;
+							if (m_Checksum == ArbotixPro::GetLowByte(m_CRC) && data == ArbotixPro::GetHighByte(m_CRC))
+								{
+									m_Start = m_Pos;
+									// an instruction packet (our own echo), not a status
+									if (m_Instruction != INST_STATUS || m_Output < 2)
+										break;
+
+									m_PacketLength = m_Output;
+									packet[0] = 0xFF;
+									packet[1] = 0xFF;
+									packet[LENGTH] = (m_PacketLength > 255) ? 255 : m_PacketLength;
+									packet[LENGTH + m_PacketLength] = m_Checksum;
+									return PACKET_OK;
+								}
+
+							m_Pos = m_Start + 1;
+							m_Start = m_Pos;
+							return PACKET_CORRUPT;
+						}
+
+					packet[ERRBIT + m_Index] = data;
+					m_Index++;
+					if (m_Index < packet[LENGTH])
+						{
+							m_Checksum += data;
+							break;
+						}
+
+					m_State = WAIT_HEADER1;
+					if (data == (unsigned char)(~m_Checksum))
+						{
+							packet[0] = 0xFF;
+							packet[1] = 0xFF;
+							m_PacketLength = packet[LENGTH];
+							m_Start = m_Pos;
+							return PACKET_OK;
+						}
+
+					// decode again from the byte after the broken header
+					m_Pos = m_Start + 1;
+					m_Start = m_Pos;
+					return PACKET_CORRUPT;
+				}
+		}
+
+	return PACKET_NONE;
+}
+
 
 ArbotixPro::ArbotixPro(PlatformArbotixPro *platform)
 {
 	m_Platform = platform;
 	DEBUG_PRINT = false;
-	m_DelayedWords = 0;
-	m_bIncludeTempData = false;
 	m_BulkReadTxPacket[LENGTH] = 0;
+	m_FeedbackChanged = false;
+	m_RefreshTime = 6.0;
+	m_SlowFeedback = FEEDBACK_LOAD | FEEDBACK_VOLTAGE | FEEDBACK_TEMPERATURE;
+	m_SlowBytes = 8;
+	m_SlowRoom = 8;
+	m_SlowTotal = 0;
+	m_SlowNext = 0;
+	m_NumSlow = 0;
+	m_Baudrate = 1000000.0;
+	m_ReturnDelayTime = 0;
+	m_PowerOnSettleTime = 300;
+	m_HasBoard = true;
+	m_Capture = 0;
+	m_BulkReadTime = 0.0;
+	m_BulkReadPending = false;
+	m_BulkReadDrained = false;
+	m_SensorTime = 0.0;
+	m_BulkReadTxLength = 0;
+	m_TxQueueLength = 0;
+	m_Protocol = PROTOCOL_1;
+	m_ReprobeNext = JointData::ID_MIN;
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		{
+			m_Feedback[id] = FEEDBACK_POSITION;
+			m_Attached[id] = true;
+			m_Misses[id] = 0;
+			m_Quarantined[id] = false;
+		}
 	for (int i = 0; i < ID_BROADCAST; i++)
 		m_BulkReadData[i] = BulkReadData();
 }
@@ -73,26 +414,50 @@ ArbotixPro::~ArbotixPro()
 	exit(0);
 }
 
-int ArbotixPro::TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int priority)
+int ArbotixPro::WritePort(unsigned char *packet, int length)
 {
-	if (priority > 1)
-		m_Platform->LowPriorityWait();
-	if (priority > 0)
-		m_Platform->MidPriorityWait();
-	m_Platform->HighPriorityWait();
+	if (m_Capture != 0)
+		m_Capture->Add(PacketCapture::DIRECTION_TX, m_Protocol, m_Platform->GetCurrentTime(), packet, length);
+
+	return m_Platform->WritePort(packet, length);
+}
+
+int ArbotixPro::TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int priority, double window)
+{
+	m_Platform->AcquireBus(priority, (window > 0.0) ? window : GetTxRxTime(txpacket));
+
+	// a pipelined bulk read response must be off the wire first, only the
+	// motion side decodes it
+	if (m_BulkReadPending == true)
+		{
+			if (priority == 0)
+				RxBulkReadPacket(m_BulkReadTxPacket, rxpacket, m_Platform->GetCurrentTime());
+			else
+				DrainBulkRead();
+		}
 
 	int res = TX_FAIL;
 	int length = txpacket[LENGTH] + 4;
+	int rx_length = 0;
+	unsigned char wire[MAXNUM_TXPACKET];
+	unsigned char *packet = txpacket;
+	double start = m_Platform->GetCurrentTime();
 
 	txpacket[0] = 0xFF;
 	txpacket[1] = 0xFF;
 	txpacket[length - 1] = CalculateChecksum(txpacket);
 
+	if (m_Protocol == PROTOCOL_2 && length < (MAXNUM_TXPARAM + 6))
+		{
+			length = MakeProtocol2Packet(txpacket, wire);
+			packet = wire;
+		}
+
 	if (DEBUG_PRINT == true)
 		{
 			fprintf(stderr, "\nTX: ");
 			for (int n = 0; n < length; n++)
-				fprintf(stderr, "%.2X ", txpacket[n]);
+				fprintf(stderr, "%.2X ", packet[n]);
 
 			fprintf(stderr, "INST: ");
 			switch (txpacket[INSTRUCTION])
@@ -135,199 +500,61 @@ int ArbotixPro::TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int
 				}
 		}
 
-	if (length < (MAXNUM_TXPARAM + 6))
+	if (txpacket[LENGTH] + 4 < (MAXNUM_TXPARAM + 6))
 		{
 			m_Platform->ClearPort();
-			if (m_Platform->WritePort(txpacket, length) == length)
+			if (WritePort(packet, length) == length)
 				{
 					if (txpacket[ID] != ID_BROADCAST)
 						{
-							int to_length = 0;
-
-							if (txpacket[INSTRUCTION] == INST_READ)
-								to_length = txpacket[PARAMETER + 1] + 6;
-							else
-								to_length = 6;
 							m_Platform->FlushPort();
 							m_Platform->SetPacketTimeout(length);
 
-							int get_length = 0;
+							m_RxParser.Reset();
 							if (DEBUG_PRINT == true)
 								fprintf(stderr, "RX: ");
 
 							while (1)
 								{
-									length = m_Platform->ReadPort(&rxpacket[get_length], to_length - get_length);
-									if (DEBUG_PRINT == true)
+									// decode what is already buffered before waiting for more
+									int status = m_RxParser.Parse(rxpacket);
+									if (status == StatusPacketParser::PACKET_OK)
 										{
-											for (int n = 0; n < length; n++)
-												fprintf(stderr, "%.2X ", rxpacket[get_length + n]);
-										}
-									get_length += length;
-
-									if (get_length == to_length)
-										{
-											// Find packet header
-											int i;
-											for (i = 0; i < (get_length - 1); i++)
-												{
-													if (rxpacket[i] == 0xFF && rxpacket[i + 1] == 0xFF)
-														break;
-													else if (i == (get_length - 2) && rxpacket[get_length - 1] == 0xFF)
-														break;
-												}
-
-											if (i == 0)
-												{
-													// Check checksum
-													unsigned char checksum = CalculateChecksum(rxpacket);
-													if (DEBUG_PRINT == true)
-														fprintf(stderr, "CHK:%.2X\n", checksum);
-
-													if (rxpacket[get_length - 1] == checksum)
-														res = SUCCESS;
-													else
-														res = RX_CORRUPT;
-
-													break;
-												}
-											else
-												{
-													for (int j = 0; j < (get_length - i); j++)
-														rxpacket[j] = rxpacket[j + i];
-													get_length -= i;
-												}
-										}
-									else
-										{
-											if (m_Platform->IsPacketTimeout() == true)
-												{
-													if (get_length == 0)
-														res = RX_TIMEOUT;
-													else
-														res = RX_CORRUPT;
-
-													break;
-												}
-										}
-								}
-						}
-					else if (txpacket[INSTRUCTION] == INST_BULK_READ)
-						{
-							int to_length = 0;
-							int num = (txpacket[LENGTH] - 3) / 3;
-
-							for (int x = 0; x < num; x++)
-								{
-									int _id = txpacket[PARAMETER + (3 * x) + 2];
-									int _len = txpacket[PARAMETER + (3 * x) + 1];
-									int _addr = txpacket[PARAMETER + (3 * x) + 3];
-
-									to_length += _len + 6;
-									m_BulkReadData[_id].length = _len;
-									m_BulkReadData[_id].start_address = _addr;
-								}
-
-							m_Platform->SetPacketTimeout(to_length * 1.5);
+											if (DEBUG_PRINT == true)
+												fprintf(stderr, "CHK:%.2X\n", rxpacket[LENGTH + rxpacket[LENGTH]]);
 
-							int get_length = 0;
-							if (DEBUG_PRINT == true)
-								fprintf(stderr, "RX: ");
+											// a status from another device is not the answer
+											if (rxpacket[ID] != txpacket[ID])
+												continue;
 
-							while (1)
-								{
-									length = m_Platform->ReadPort(&rxpacket[get_length], to_length - get_length);
-									if (DEBUG_PRINT == true)
-										{
-											for (int n = 0; n < length; n++)
-												fprintf(stderr, "%.2X ", rxpacket[get_length + n]);
-										}
-									get_length += length;
-
-									if (get_length == to_length)
-										{
-											res = SUCCESS;
+											if (txpacket[INSTRUCTION] == INST_READ && rxpacket[LENGTH] != txpacket[PARAMETER + 1] + 2)
+												res = RX_CORRUPT;
+											else
+												res = SUCCESS;
 											break;
 										}
-									else
+									else if (status == StatusPacketParser::PACKET_CORRUPT)
 										{
-											if (m_Platform->IsPacketTimeout() == true)
-												{
-													if (get_length == 0)
-														res = RX_TIMEOUT;
-													else
-														res = RX_CORRUPT;
-
-													break;
-												}
+											res = RX_CORRUPT;
+											break;
 										}
-								}
-
-							for (int x = 0; x < num; x++)
-								{
-									int _id = txpacket[PARAMETER + (3 * x) + 2];
-									m_BulkReadData[_id].error = -1;
-								}
-
-							while (1)
-								{
-									int i;
-									for (i = 0; i < get_length - 1; i++)
+									else if (m_Platform->IsPacketTimeout() == true || (window > 0.0 && m_Platform->GetPacketTime() > window))
 										{
-											if (rxpacket[i] == 0xFF && rxpacket[i + 1] == 0xFF)
-												break;
-											else if (i == (get_length - 2) && rxpacket[get_length - 1] == 0xFF)
-												break;
-										}
-
-									if (i == 0)
-										{
-											// Check checksum
-											unsigned char checksum = CalculateChecksum(rxpacket);
-											if (DEBUG_PRINT == true)
-												fprintf(stderr, "CHK:%.2X\n", checksum);
-
-											if (rxpacket[LENGTH + rxpacket[LENGTH]] == checksum)
-												{
-													for (int j = 0; j < (rxpacket[LENGTH] - 2); j++)
-														m_BulkReadData[rxpacket[ID]].table[m_BulkReadData[rxpacket[ID]].start_address + j] = rxpacket[PARAMETER + j];
-
-													m_BulkReadData[rxpacket[ID]].error = (int)rxpacket[ERRBIT];
-
-													int cur_packet_length = LENGTH + 1 + rxpacket[LENGTH];
-													to_length = get_length - cur_packet_length;
-													for (int j = 0; j <= to_length; j++)
-														rxpacket[j] = rxpacket[j + cur_packet_length];
-
-													get_length = to_length;
-													num--;
-												}
+											if (m_RxParser.GetReceived() == 0)
+												res = RX_TIMEOUT;
 											else
-												{
-													res = RX_CORRUPT;
-
-													for (int j = 0; j <= get_length - 2; j++)
-														rxpacket[j] = rxpacket[j + 2];
-
-													to_length = get_length -= 2;
-												}
-
-											if (num == 0)
-												break;
-											else if (get_length <= 6)
-												{
-													if (num != 0) res = RX_CORRUPT;
-													break;
-												}
-
+												res = RX_CORRUPT;
+											break;
 										}
 									else
-										{
-											for (int j = 0; j < (get_length - i); j++)
-												rxpacket[j] = rxpacket[j + i];
-											get_length -= i;
-										}
+										m_RxParser.Fill(m_Platform, DEBUG_PRINT);
 								}
+							rx_length = m_RxParser.GetReceived();
+						}
+					else if (txpacket[INSTRUCTION] == INST_BULK_READ)
+						{
+							m_BulkReadTxLength = length;
+							res = RxBulkReadPacket(txpacket, rxpacket, start);
 						}
 					else
 						res = SUCCESS;
@@ -338,6 +565,13 @@ int ArbotixPro::TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int
 	else
 		res = TX_CORRUPT;
 
+	// a bulk read is counted when its response is collected
+	if (txpacket[INSTRUCTION] != INST_BULK_READ)
+		m_Statistics.Record(GetStatisticsType(txpacket[INSTRUCTION]), txpacket[ID], res, length, rx_length, m_Platform->GetCurrentTime() - start);
+
+	if (res == SUCCESS)
+		UpdateShadow(txpacket, rxpacket, start);
+
 	if (DEBUG_PRINT == true)
 		{
 			fprintf(stderr, "Time:%.2fms  ", m_Platform->GetPacketTime());
@@ -374,60 +608,614 @@ int ArbotixPro::TxRxPacket(unsigned char *txpacket, unsigned char *rxpacket, int
 				}
 		}
 
-	m_Platform->HighPriorityRelease();
-	if (priority > 0)
-		m_Platform->MidPriorityRelease();
-	if (priority > 1)
-		m_Platform->LowPriorityRelease();
+	m_Platform->ReleaseBus(priority);
 
 	return res;
 }
 
-unsigned char ArbotixPro::CalculateChecksum(unsigned char *packet)
+int ArbotixPro::RxBulkReadPacket(unsigned char *txpacket, unsigned char *rxpacket, double start)
+{
+	int res = SUCCESS;
+	int num = (txpacket[LENGTH] - 3) / 3;
+	unsigned char pending[ID_BROADCAST] = {0, };
+	unsigned char length[ID_BROADCAST];
+	// the per-tick feedback goes to m_BulkReadData, any other bulk read only to the shadow table
+	bool feedback = (txpacket == m_BulkReadTxPacket);
+	StatusPacketParser *parser = (feedback == true) ? &m_BulkReadParser : &m_RxParser;
+	double time = (feedback == true) ? m_SensorTime : start;
+	// taken off the wire already by DrainBulkRead()
+	bool drained = (feedback == true && m_BulkReadDrained == true);
+
+	for (int x = 0; x < num; x++)
+		{
+			int _id = txpacket[PARAMETER + (3 * x) + 2];
+			int _len = txpacket[PARAMETER + (3 * x) + 1];
+			int _addr = txpacket[PARAMETER + (3 * x) + 3];
+
+			if (feedback == true)
+				{
+					m_BulkReadData[_id].length = _len;
+					m_BulkReadData[_id].start_address = _addr;
+				}
+			length[_id] = _len;
+			pending[_id] = 1;
+		}
+
+	m_Platform->SetPacketTimeout(GetBulkReadTimeout(txpacket));
+
+	m_BulkReadPending = false;
+	m_BulkReadDrained = false;
+	if (drained == false)
+		parser->Reset();
+	if (DEBUG_PRINT == true)
+		fprintf(stderr, "RX: ");
+
+	while (num > 0)
+		{
+			// decode what is already buffered before waiting for more
+			int status = parser->Parse(rxpacket);
+			if (status == StatusPacketParser::PACKET_OK && m_Protocol == PROTOCOL_2)
+				{
+					// Fast Bulk Read, every device is in the one status packet
+					if (rxpacket[ID] != ID_BROADCAST)
+						continue;
+
+					num -= DecodeFastBulkRead(txpacket, rxpacket, parser->GetLength(), pending, feedback, time);
+					if (num > 0)
+						res = RX_CORRUPT;
+					break;
+				}
+			else if (status == StatusPacketParser::PACKET_OK)
+				{
+					int _id = rxpacket[ID];
+					int data_length = rxpacket[LENGTH] - 2;
+
+					if (DEBUG_PRINT == true)
+						fprintf(stderr, "CHK:%.2X\n", rxpacket[LENGTH + rxpacket[LENGTH]]);
+
+					// only accept the packet an ID was asked for, and only once
+					if (_id >= ID_BROADCAST || pending[_id] == 0 || data_length != length[_id])
+						continue;
+
+					StoreBulkReadData(txpacket, _id, &rxpacket[PARAMETER], rxpacket[ERRBIT], feedback, time);
+					pending[_id] = 0;
+					m_Statistics.RecordDevice(rxpacket[ID], SUCCESS, rxpacket[LENGTH] + 4);
+					num--;
+				}
+			else if (status == StatusPacketParser::PACKET_CORRUPT)
+				{
+					res = RX_CORRUPT;
+					if (m_Protocol == PROTOCOL_2)
+						break;
+				}
+			else if (drained == true || m_Platform->IsPacketTimeout() == true)
+				{
+					if (parser->GetReceived() == 0)
+						res = RX_TIMEOUT;
+					else
+						res = RX_CORRUPT;
+					break;
+				}
+			else
+				parser->Fill(m_Platform, DEBUG_PRINT);
+		}
+
+	for (int _id = 0; _id < ID_BROADCAST; _id++)
+		{
+			if (pending[_id] != 0)
+				{
+					if (feedback == true)
+						m_BulkReadData[_id].error = -1;
+					m_Statistics.RecordDevice(_id, RX_TIMEOUT, 0);
+				}
+		}
+	if (feedback == true)
+		UpdateHealth(txpacket, pending);
+	m_Statistics.Record(BusStatistics::BULK_READ, ID_BROADCAST, res, m_BulkReadTxLength, parser->GetReceived(), m_Platform->GetCurrentTime() - start);
+
+	return res;
+}
+
+// Bytes of the response to a bulk read, with every return delay counted
+// in bytes, as the packet timeout wants it.
+int ArbotixPro::GetBulkReadTimeout(unsigned char *txpacket)
+{
+	int num = (txpacket[LENGTH] - 3) / 3;
+	int to_length = (m_Protocol == PROTOCOL_2) ? HEADER_LENGTH2 + 1 : 0;
+
+	for (int x = 0; x < num; x++)
+		to_length += txpacket[PARAMETER + (3 * x) + 1] + ((m_Protocol == PROTOCOL_2) ? 4 : 6);
+
+	// every device waits its return delay (once for the Fast Bulk Read)
+	int delays = (m_Protocol == PROTOCOL_2) ? 1 : num;
+	to_length += (int)(delays * m_ReturnDelayTime * 0.002 / GetTransferTime(1));
+
+	return (int)(to_length * 1.5);
+}
+
+// Takes the pending response off the wire for a transaction of another
+// thread. It is decoded on the motion side by the next RxBulkReadPacket(),
+// so m_BulkReadData and the health counts have a single writer.
+void ArbotixPro::DrainBulkRead()
+{
+	if (m_BulkReadDrained == true)
+		return;
+
+	int num = (m_BulkReadTxPacket[LENGTH] - 3) / 3;
+	unsigned int expected = (m_Protocol == PROTOCOL_2) ? HEADER_LENGTH2 + 1 : 0;
+	for (int x = 0; x < num; x++)
+		expected += m_BulkReadTxPacket[PARAMETER + (3 * x) + 1] + ((m_Protocol == PROTOCOL_2) ? 4 : 6);
+
+	m_BulkReadDrained = true;
+	m_BulkReadParser.Reset();
+	m_Platform->SetPacketTimeout(GetBulkReadTimeout(m_BulkReadTxPacket));
+	while (m_BulkReadParser.GetReceived() < expected && m_Platform->IsPacketTimeout() == false)
+		m_BulkReadParser.Fill(m_Platform, DEBUG_PRINT);
+}
+
+void ArbotixPro::StoreBulkReadData(unsigned char *txpacket, int id, unsigned char *data, int error, bool feedback, double time)
+{
+	int num = (txpacket[LENGTH] - 3) / 3;
+	int x = 0;
+
+	while (x < num && txpacket[PARAMETER + (3 * x) + 2] != id)
+		x++;
+	if (x == num)
+		return;
+
+	int _len = txpacket[PARAMETER + (3 * x) + 1];
+	int _addr = txpacket[PARAMETER + (3 * x) + 3];
+	if (_addr + _len > MAXNUM_TABLE)
+		return;
+
+	if (feedback == true)
+		{
+			for (int j = 0; j < _len; j++)
+				{
+					m_BulkReadData[id].table[_addr + j] = data[j];
+					m_BulkReadData[id].received[_addr + j] = true;
+				}
+			m_BulkReadData[id].error = error;
+		}
+
+	if (error == 0)
+		m_Shadow.Update(id, _addr, data, _len, time);
+}
+
+void ArbotixPro::UpdateShadow(unsigned char *txpacket, unsigned char *rxpacket, double time)
+{
+	int id = txpacket[ID];
+
+	switch (txpacket[INSTRUCTION])
+		{
+		case INST_READ:
+			if (id != ID_BROADCAST && rxpacket != 0 && rxpacket[ERRBIT] == 0)
+				m_Shadow.Update(id, txpacket[PARAMETER], &rxpacket[PARAMETER], txpacket[PARAMETER + 1], time);
+			break;
+
+		case INST_WRITE:
+			if (id == ID_BROADCAST)
+				{
+					for (int n = 0; n < ID_BROADCAST; n++)
+						m_Shadow.Write(n, txpacket[PARAMETER], &txpacket[PARAMETER + 1], txpacket[LENGTH] - 3, time);
+				}
+			else
+				m_Shadow.Write(id, txpacket[PARAMETER], &txpacket[PARAMETER + 1], txpacket[LENGTH] - 3, time);
+			break;
+
+		case INST_SYNC_WRITE:
+			{
+				int each_length = txpacket[PARAMETER + 1] + 1;
+				int num = (txpacket[LENGTH] - 4) / each_length;
+
+				for (int x = 0; x < num; x++)
+					{
+						unsigned char *param = &txpacket[PARAMETER + 2 + (x * each_length)];
+						m_Shadow.Write(param[0], txpacket[PARAMETER], &param[1], each_length - 1, time);
+					}
+			}
+			break;
+		}
+}
+
+int ArbotixPro::DecodeFastBulkRead(unsigned char *txpacket, unsigned char *rxpacket, int rx_length, unsigned char *pending, bool feedback, double time)
+{
+	// ERR ID DATA... CRC_L CRC_H for every device in the order of the request,
+	// the CRC of the last one is the packet CRC and already checked
+	int num = (txpacket[LENGTH] - 3) / 3;
+	int end = PARAMETER + rx_length - 2;
+	int pos = ERRBIT;
+	int count = 0;
+
+	for (int x = 0; x < num; x++)
+		{
+			int _len = txpacket[PARAMETER + (3 * x) + 1];
+			int _id = txpacket[PARAMETER + (3 * x) + 2];
+
+			if (pos + 2 + _len > end || rxpacket[pos + 1] != _id)
+				break;
+
+			StoreBulkReadData(txpacket, _id, &rxpacket[pos + 2], rxpacket[pos], feedback, time);
+			pending[_id] = 0;
+			m_Statistics.RecordDevice(_id, SUCCESS, _len + 4);
+			count++;
+			pos += _len + 4;
+		}
+
+	return count;
+}
+
+int ArbotixPro::GetStatisticsType(int instruction)
+{
+	switch (instruction)
+		{
+		case INST_PING:
+			return BusStatistics::PING;
+		case INST_READ:
+			return BusStatistics::READ;
+		case INST_WRITE:
+			return BusStatistics::WRITE;
+		case INST_SYNC_WRITE:
+			return BusStatistics::SYNC_WRITE;
+		case INST_BULK_READ:
+			return BusStatistics::BULK_READ;
+		default:
+			return BusStatistics::OTHER;
+		}
+}
+
+unsigned char ArbotixPro::CalculateChecksum(unsigned char *packet)
+{
+	unsigned char checksum = 0x00;
+	for (int i = 2; i < packet[LENGTH] + 3; i++ )
+		checksum += packet[i];
+	return (~checksum);
+}
+
+unsigned short ArbotixPro::UpdateCRC(unsigned short crc, const unsigned char *data, int length)
+{
+	for (int i = 0; i < length; i++)
+		crc = (unsigned short)((crc << 8) ^ CRCTable[((crc >> 8) ^ data[i]) & 0xFF]);
+
+	return crc;
+}
+
+int ArbotixPro::MakeProtocol2Packet(unsigned char *txpacket, unsigned char *packet)
+{
+	unsigned char body[MAXNUM_TXPACKET];
+	unsigned char *param = &txpacket[PARAMETER];
+	int num_param = txpacket[LENGTH] - 2;
+	int length = 0;
+	int n;
+
+	// addresses and lengths become 16 bit
+	switch (txpacket[INSTRUCTION])
+		{
+		case INST_READ:
+			body[length++] = INST_READ;
+			body[length++] = param[0];
+			body[length++] = 0;
+			body[length++] = param[1];
+			body[length++] = 0;
+			break;
+
+		case INST_WRITE:
+		case INST_REG_WRITE:
+			body[length++] = txpacket[INSTRUCTION];
+			body[length++] = param[0];
+			body[length++] = 0;
+			for (n = 1; n < num_param; n++)
+				body[length++] = param[n];
+			break;
+
+		case INST_SYNC_WRITE:
+			body[length++] = INST_SYNC_WRITE;
+			body[length++] = param[0];
+			body[length++] = 0;
+			body[length++] = param[1];
+			body[length++] = 0;
+			for (n = 2; n < num_param; n++)
+				body[length++] = param[n];
+			break;
+
+		case INST_BULK_READ:
+			// (length, id, address) -> (id, address, length)
+			body[length++] = INST_FAST_BULK_READ;
+			for (n = 1; n + 3 <= num_param; n += 3)
+				{
+					body[length++] = param[n + 1];
+					body[length++] = param[n + 2];
+					body[length++] = 0;
+					body[length++] = param[n];
+					body[length++] = 0;
+				}
+			break;
+
+		default:
+			body[length++] = txpacket[INSTRUCTION];
+			for (n = 0; n < num_param; n++)
+				body[length++] = param[n];
+			break;
+		}
+
+	packet[0] = Header2[0];
+	packet[1] = Header2[1];
+	packet[2] = Header2[2];
+	packet[3] = Header2[3];
+	packet[4] = txpacket[ID];
+
+	// 0xFD is stuffed after every 0xFF 0xFF 0xFD
+	int stuffing = 0;
+	int pos = HEADER_LENGTH2;
+	for (n = 0; n < length; n++)
+		{
+			packet[pos++] = body[n];
+			if (body[n] == 0xFF)
+				stuffing = (stuffing == 1 || stuffing == 2) ? 2 : 1;
+			else if (body[n] == 0xFD && stuffing == 2)
+				{
+					packet[pos++] = 0xFD;
+					stuffing = 0;
+				}
+			else
+				stuffing = 0;
+		}
+
+	packet[5] = (unsigned char)GetLowByte(pos - HEADER_LENGTH2 + 2);
+	packet[6] = (unsigned char)GetHighByte(pos - HEADER_LENGTH2 + 2);
+
+	unsigned short crc = UpdateCRC(0, packet, pos);
+	packet[pos++] = (unsigned char)GetLowByte(crc);
+	packet[pos++] = (unsigned char)GetHighByte(crc);
+
+	return pos;
+}
+
+double ArbotixPro::GetTxRxTime(unsigned char *txpacket)
+{
+	int bytes = txpacket[LENGTH] + 4;
+	int status = 6;
+
+	// longer header, 16 bit length, address and CRC
+	if (m_Protocol == PROTOCOL_2)
+		{
+			bytes += 5;
+			status = 11;
+		}
+
+	if (txpacket[ID] == ID_BROADCAST)
+		{
+			if (txpacket == m_BulkReadTxPacket)
+				return m_BulkReadTime;
+			if (txpacket[INSTRUCTION] == INST_BULK_READ)
+				{
+					for (int x = 0; x < (txpacket[LENGTH] - 3) / 3; x++)
+						bytes += txpacket[PARAMETER + (3 * x) + 1] + status;
+				}
+		}
+	else if (txpacket[INSTRUCTION] == INST_READ)
+		bytes += txpacket[PARAMETER + 1] + status;
+	else
+		bytes += status;
+
+	return GetTransferTime(bytes) + 1.0; // + USB turnaround
+}
+
+double ArbotixPro::GetTransferTime(int bytes)
+{
+	return (double)bytes * 10.0 * 1000.0 / m_Baudrate; // 1 start + 8 data + 1 stop bit
+}
+
+void ArbotixPro::SetProtocol(int protocol)
+{
+	m_Protocol = protocol;
+	m_RxParser.SetProtocol(protocol);
+	m_BulkReadParser.SetProtocol(protocol);
+	m_FeedbackChanged = true;
+}
+
+void ArbotixPro::SetFeedback(int fields)
+{
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		m_Feedback[id] = fields;
+	m_FeedbackChanged = true;
+}
+
+void ArbotixPro::UpdateHealth(unsigned char *txpacket, unsigned char *pending)
+{
+	int num = (txpacket[LENGTH] - 3) / 3;
+
+	for (int x = 0; x < num; x++)
+		{
+			int id = txpacket[PARAMETER + (3 * x) + 2];
+			if (id >= JointData::NUMBER_OF_JOINTS)
+				{
+					if (pending[id] != 0)
+						break;
+					continue;
+				}
+
+			if (pending[id] == 0)
+				{
+					m_Misses[id] = 0;
+					continue;
+				}
+
+			// the devices after this one in the list did not get their turn
+			if (++m_Misses[id] >= QUARANTINE_MISSES && m_Quarantined[id] == false)
+				{
+					m_Quarantined[id] = true;
+					m_FeedbackChanged = true;
+					if (DEBUG_PRINT == true)
+						fprintf(stderr, "ID:%d quarantined after %d missed bulk reads\n", id, m_Misses[id]);
+				}
+			break;
+		}
+}
+
+bool ArbotixPro::HasQuarantined()
+{
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			if (m_Quarantined[id] == true)
+				return true;
+		}
+
+	return false;
+}
+
+int ArbotixPro::Reprobe()
+{
+	for (int i = 0; i < JointData::NUMBER_OF_JOINTS - 1; i++)
+		{
+			int id = m_ReprobeNext;
+			if (++m_ReprobeNext > JointData::ID_MAX)
+				m_ReprobeNext = JointData::ID_MIN;
+
+			if (m_Quarantined[id] == false)
+				continue;
+
+			unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
+			unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
+			txpacket[ID]           = (unsigned char)id;
+			txpacket[INSTRUCTION]  = INST_PING;
+			txpacket[LENGTH]       = 2;
+
+			// at app priority in the idle slot between the ticks, waiting no
+			// longer for the answer than it takes an answering servo
+			double window = GetTxRxTime(txpacket) + m_ReturnDelayTime * 0.002 + 1.0;
+			int res = TxRxPacket(txpacket, rxpacket, 2, window);
+			if (res == SUCCESS)
+				{
+					m_Misses[id] = 0;
+					m_Quarantined[id] = false;
+					// the motion thread rebuilds the bulk read with it
+					__sync_synchronize();
+					m_FeedbackChanged = true;
+					if (DEBUG_PRINT == true)
+						fprintf(stderr, "ID:%d answers again\n", id);
+				}
+			return res;
+		}
+
+	return SUCCESS;
+}
+
+void ArbotixPro::ResetHealth()
+{
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		{
+			m_Misses[id] = 0;
+			m_Quarantined[id] = false;
+		}
+	m_FeedbackChanged = true;
+}
+
+void ArbotixPro::SetJointAttached(int id, bool attached)
+{
+	if (id < JointData::ID_MIN || id > JointData::ID_MAX)
+		return;
+
+	m_Attached[id] = attached;
+	m_FeedbackChanged = true;
+}
+
+void ArbotixPro::SetFeedback(int id, int fields)
+{
+	if (id < JointData::ID_MIN || id > JointData::ID_MAX)
+		return;
+
+	m_Feedback[id] = fields;
+	m_FeedbackChanged = true;
+}
+
+// flag, start address, length (in address order)
+#define NUM_FEEDBACK_FIELDS	(5)
+static const int FeedbackField[NUM_FEEDBACK_FIELDS][3] =
 {
-	unsigned char checksum = 0x00;
-	for (int i = 2; i < packet[LENGTH] + 3; i++ )
-		checksum += packet[i];
-	return (~checksum);
+	{ ArbotixPro::FEEDBACK_POSITION,	AXDXL::P_PRESENT_POSITION_L,	2 },
+	{ ArbotixPro::FEEDBACK_SPEED,		AXDXL::P_PRESENT_SPEED_L,		2 },
+	{ ArbotixPro::FEEDBACK_LOAD,		AXDXL::P_PRESENT_LOAD_L,		2 },
+	{ ArbotixPro::FEEDBACK_VOLTAGE,		AXDXL::P_PRESENT_VOLTAGE,		1 },
+	{ ArbotixPro::FEEDBACK_TEMPERATURE,	AXDXL::P_PRESENT_TEMPERATURE,	1 }
+};
+
+// Bytes the block start_addr ~ end_addr grows by with the slow fields,
+// which are added to it.
+static int SlowFieldsExtra(int slow, int *start_addr, int *end_addr)
+{
+	int length = *end_addr - *start_addr + 1;
+
+	for (int f = 0; f < NUM_FEEDBACK_FIELDS; f++)
+		{
+			if ((slow & FeedbackField[f][0]) == 0)
+				continue;
+			if (FeedbackField[f][1] < *start_addr)
+				*start_addr = FeedbackField[f][1];
+			if (FeedbackField[f][1] + FeedbackField[f][2] - 1 > *end_addr)
+				*end_addr = FeedbackField[f][1] + FeedbackField[f][2] - 1;
+		}
+
+	return *end_addr - *start_addr + 1 - length;
 }
 
-void ArbotixPro::MakeBulkReadPacket()
+double ArbotixPro::MakeBulkReadPacket(int dropped)
 {
 	int number = 0;
+	int joints = 0;
+	int data_bytes = 0;
+	int slow_max = 0;		// the slow fields of one joint
 
+	m_SlowTotal = 0;
 	m_BulkReadTxPacket[ID]              = (unsigned char)ID_BROADCAST;
 	m_BulkReadTxPacket[INSTRUCTION]     = INST_BULK_READ;
 	m_BulkReadTxPacket[PARAMETER]       = (unsigned char)0x0;
 
 	//if(Ping(ArbotixPro::ID_CM, 0) == SUCCESS)
+	if (m_HasBoard == true)
 	{
 		m_BulkReadTxPacket[PARAMETER + 3 * number + 1] = 30;
 		m_BulkReadTxPacket[PARAMETER + 3 * number + 2] = ArbotixPro::ID_CM;
 		m_BulkReadTxPacket[PARAMETER + 3 * number + 3] = ArbotixPro::P_DXL_POWER;
+		data_bytes += 30;
 		number++;
 	}
 
-//    for(int id = 1; id < JointData::NUMBER_OF_JOINTS; id++)
-//    {
-//        if(MotionStatus::m_CurrentJoints.GetEnable(id))
-//        {
-//            m_BulkReadTxPacket[PARAMETER+3*number+1] = 2;   // length
-//            m_BulkReadTxPacket[PARAMETER+3*number+2] = id;  // id
-//            m_BulkReadTxPacket[PARAMETER+3*number+3] = AXDXL::P_PRESENT_POSITION_L; // start address
-//            number++;
-//        }
-//    }
-	if (m_bIncludeTempData == true)
-		{
-			for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			if (MotionStatus::m_CurrentJoints.GetEnable(id) == false || m_Attached[id] == false || m_Quarantined[id] == true)
+				continue;
+
+			joints++;
+
+			int fields = m_Feedback[id] & ~dropped;
+			if (fields == FEEDBACK_NONE)
+				continue;
+
+			// one contiguous block from the first to the last requested field
+			int start_addr = -1;
+			int end_addr = -1;
+			for (int i = 0; i < NUM_FEEDBACK_FIELDS; i++)
 				{
-					if (MotionStatus::m_CurrentJoints.GetEnable(id))
-						{
-							m_BulkReadTxPacket[PARAMETER + 3 * number + 1] = 1; // length
-							m_BulkReadTxPacket[PARAMETER + 3 * number + 2] = id; // id
-							m_BulkReadTxPacket[PARAMETER + 3 * number + 3] = AXDXL::P_PRESENT_TEMPERATURE; // start address
-							number++;
-						}
+					if ((fields & FeedbackField[i][0]) == 0)
+						continue;
+					if (start_addr < 0)
+						start_addr = FeedbackField[i][1];
+					end_addr = FeedbackField[i][1] + FeedbackField[i][2] - 1;
+				}
+
+			m_BulkReadTxPacket[PARAMETER + 3 * number + 1] = end_addr - start_addr + 1; // length
+			m_BulkReadTxPacket[PARAMETER + 3 * number + 2] = id; // id
+			m_BulkReadTxPacket[PARAMETER + 3 * number + 3] = start_addr; // start address
+			data_bytes += end_addr - start_addr + 1;
+			number++;
+
+			if (m_SlowFeedback != FEEDBACK_NONE)
+				{
+					int extra = SlowFieldsExtra(m_SlowFeedback, &start_addr, &end_addr);
+					if (extra > slow_max)
+						slow_max = extra;
+					m_SlowTotal += extra;
 				}
 		}
 	/*
@@ -450,14 +1238,139 @@ void ArbotixPro::MakeBulkReadPacket()
 	//fprintf(stderr, "NUMBER : %d \n", number);
 
 	m_BulkReadTxPacket[LENGTH]          = (number * 3) + 3;
+
+	// wire time of one tick: the goal SyncWrite, the bulk read request and
+	// every status packet with its return delay
+	// and the slow fields, at least one joint's as ScheduleSlowFeedback() always takes one
+	m_SlowRoom = (slow_max > m_SlowBytes) ? slow_max : m_SlowBytes;
+	if (m_SlowFeedback != FEEDBACK_NONE)
+		data_bytes += m_SlowRoom;
+	if (m_Protocol == PROTOCOL_2)
+		{
+			// one Fast Bulk Read status with ERR, ID, data and CRC per device
+			int tx_bytes = (joints * 5 + 14) + (number * 5 + 10);
+			int rx_bytes = data_bytes + number * 4 + 8;
+			m_BulkReadTime = GetTransferTime(tx_bytes + rx_bytes) + m_ReturnDelayTime * 0.002;
+		}
+	else
+		{
+			int tx_bytes = (joints * 5 + 8) + (m_BulkReadTxPacket[LENGTH] + 4);
+			int rx_bytes = data_bytes + number * 6;
+			m_BulkReadTime = GetTransferTime(tx_bytes + rx_bytes) + number * m_ReturnDelayTime * 0.002;
+		}
+	return m_BulkReadTime;
+}
+
+void ArbotixPro::MakeBulkReadPacket()
+{
+	// fields given up, in this order, when the bus can not carry them every tick
+	static const int drop_order[] = { FEEDBACK_VOLTAGE, FEEDBACK_LOAD, FEEDBACK_SPEED, FEEDBACK_TEMPERATURE };
+	int dropped = FEEDBACK_NONE;
+
+	m_FeedbackChanged = false;
+	m_NumSlow = 0;
+	for (int i = 0; MakeBulkReadPacket(dropped) > m_RefreshTime; i++)
+		{
+			if (i == (int)(sizeof(drop_order) / sizeof(drop_order[0])))
+				{
+					fprintf(stderr, " Bulk read needs %.2fmsec of bus time at %.0fbps (budget %.1fmsec)\n", m_BulkReadTime, m_Baudrate, m_RefreshTime);
+					return;
+				}
+			dropped |= drop_order[i];
+		}
+
+	// the bus time left in the budget goes to the slow fields as well
+	if (m_SlowFeedback != FEEDBACK_NONE && m_SlowTotal > m_SlowRoom)
+		{
+			int spare = (int)((m_RefreshTime - m_BulkReadTime) / GetTransferTime(1));
+			if (spare > m_SlowTotal - m_SlowRoom)
+				spare = m_SlowTotal - m_SlowRoom;
+			if (spare > 0)
+				{
+					m_SlowRoom += spare;
+					m_BulkReadTime += GetTransferTime(spare);
+				}
+		}
+
+	if (dropped != FEEDBACK_NONE)
+		fprintf(stderr, " Bulk read exceeds the %.1fmsec bus budget at %.0fbps, feedback 0x%02X dropped (%.2fmsec)\n", m_RefreshTime, m_Baudrate, dropped, m_BulkReadTime);
+	else if (DEBUG_PRINT == true)
+		fprintf(stderr, " Bulk read uses %.2fmsec of the %.1fmsec bus budget\n", m_BulkReadTime, m_RefreshTime);
+}
+
+void ArbotixPro::SetSlowFeedback(int fields, int bytes)
+{
+	m_SlowFeedback = fields;
+	m_SlowBytes = bytes;
+	m_FeedbackChanged = true;
+}
+
+// Puts the joints of the last tick back to their own fields and extends
+// the entries of the next ones in turn. Only between two bulk reads: the
+// response is decoded against the packet that was sent.
+void ArbotixPro::ScheduleSlowFeedback()
+{
+	int num = (m_BulkReadTxPacket[LENGTH] - 3) / 3;
+	int bytes = 0;
+
+	for (int i = 0; i < m_NumSlow; i++)
+		{
+			m_BulkReadTxPacket[PARAMETER + 3 * m_SlowEntry[i] + 1] = m_SlowLength[i];
+			m_BulkReadTxPacket[PARAMETER + 3 * m_SlowEntry[i] + 3] = m_SlowAddress[i];
+		}
+	m_NumSlow = 0;
+
+	if (m_SlowFeedback == FEEDBACK_NONE || num <= 0)
+		return;
+
+	for (int i = 0; i < num && m_NumSlow < JointData::NUMBER_OF_JOINTS; i++)
+		{
+			int x = m_SlowNext;
+			if (++m_SlowNext >= num)
+				m_SlowNext = 0;
+
+			unsigned char *entry = &m_BulkReadTxPacket[PARAMETER + 3 * x + 1];	// length, id, address
+			if (entry[1] >= JointData::NUMBER_OF_JOINTS)
+				continue;
+
+			int start_addr = entry[2];
+			int end_addr = entry[2] + entry[0] - 1;
+			int extra = SlowFieldsExtra(m_SlowFeedback, &start_addr, &end_addr);
+			if (m_NumSlow > 0 && bytes + extra > m_SlowRoom)
+				{
+					m_SlowNext = x;
+					break;
+				}
+
+			m_SlowEntry[m_NumSlow] = x;
+			m_SlowLength[m_NumSlow] = entry[0];
+			m_SlowAddress[m_NumSlow] = entry[2];
+			m_NumSlow++;
+			entry[0] = end_addr - start_addr + 1;
+			entry[2] = start_addr;
+			bytes += extra;
+			if (bytes >= m_SlowRoom)
+				break;
+		}
 }
 
 int ArbotixPro::BulkRead()
 {
 	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
 
+	// the packet is about to change, the previous response has to be read against it
+	if (m_BulkReadPending == true)
+		CollectBulkRead();
+
+	if (m_FeedbackChanged == true)
+		MakeBulkReadPacket();
+	ScheduleSlowFeedback();
+
 	if (m_BulkReadTxPacket[LENGTH] != 0)
-		return TxRxPacket(m_BulkReadTxPacket, rxpacket, 0);
+		{
+			m_SensorTime = m_Platform->GetCurrentTime();
+			return TxRxPacket(m_BulkReadTxPacket, rxpacket, 0);
+		}
 	else
 		{
 			MakeBulkReadPacket();
@@ -465,6 +1378,228 @@ int ArbotixPro::BulkRead()
 		}
 }
 
+int ArbotixPro::QueuePacket(unsigned char *txpacket)
+{
+	int length = txpacket[LENGTH] + 4;
+	// byte stuffing may grow a Protocol 2.0 packet by a third
+	int room = (m_Protocol == PROTOCOL_2) ? length * 4 / 3 + 16 : length;
+
+	// keep room for the bulk read request
+	if (length >= MAXNUM_TXPARAM + 6 || m_TxQueueLength + room > MAXNUM_TXQUEUE - MAXNUM_TXPACKET)
+		return TX_CORRUPT;
+
+	m_TxQueueLength += AppendPacket(txpacket, m_TxQueue, m_TxQueueLength);
+
+	return SUCCESS;
+}
+
+// frames txpacket at queue[length], returns the bytes it takes on the wire
+int ArbotixPro::AppendPacket(unsigned char *txpacket, unsigned char *queue, int length)
+{
+	int n = txpacket[LENGTH] + 4;
+
+	txpacket[0] = 0xFF;
+	txpacket[1] = 0xFF;
+	txpacket[n - 1] = CalculateChecksum(txpacket);
+
+	if (m_Protocol == PROTOCOL_2)
+		n = MakeProtocol2Packet(txpacket, &queue[length]);
+	else
+		{
+			for (int i = 0; i < n; i++)
+				queue[length + i] = txpacket[i];
+		}
+
+	UpdateShadow(txpacket, 0, m_Platform->GetCurrentTime());
+
+	return n;
+}
+
+int ArbotixPro::QueueSyncWrite(int start_addr, int each_length, int number, int *pParam)
+{
+	unsigned char txpacket[MAXNUM_TXPARAM + 10];
+	int n;
+
+	if (number <= 0)
+		return SUCCESS;
+	if (number * each_length + 8 >= MAXNUM_TXPARAM + 6)
+		return TX_CORRUPT;
+
+	txpacket[ID]                = (unsigned char)ID_BROADCAST;
+	txpacket[INSTRUCTION]       = INST_SYNC_WRITE;
+	txpacket[PARAMETER]			= (unsigned char)start_addr;
+	txpacket[PARAMETER + 1]		= (unsigned char)(each_length - 1);
+	for (n = 0; n < (number * each_length); n++)
+		txpacket[PARAMETER + 2 + n]   = (unsigned char)pParam[n];
+	txpacket[LENGTH]            = n + 4;
+
+	return QueuePacket(txpacket);
+}
+
+int ArbotixPro::QueueDelayedWrites()
+{
+	CommandQueue::Command command[CommandQueue::CAPACITY];
+	bool done[CommandQueue::CAPACITY];
+	int num = 0;
+	int res = SUCCESS;
+
+	while (num < CommandQueue::CAPACITY && m_Commands.Pop(&command[num]) == true)
+		{
+			done[num] = false;
+			num++;
+		}
+
+	for (int i = 0; i < num; i++)
+		{
+			if (done[i] == true)
+				continue;
+
+			int address = command[i].address;
+			int length = command[i].length;
+
+			if (command[i].id == ID_BROADCAST)
+				{
+					unsigned char txpacket[MAXNUM_TXPARAM + 10];
+
+					txpacket[ID]            = (unsigned char)ID_BROADCAST;
+					txpacket[INSTRUCTION]   = INST_WRITE;
+					txpacket[PARAMETER]     = (unsigned char)address;
+					txpacket[PARAMETER + 1] = (unsigned char)GetLowByte(command[i].value);
+					txpacket[PARAMETER + 2] = (unsigned char)GetHighByte(command[i].value);
+					txpacket[LENGTH]        = length + 3;
+					if (QueuePacket(txpacket) != SUCCESS)
+						{
+							m_Commands.AddOverflow(1);
+							res = TX_CORRUPT;
+						}
+					done[i] = true;
+					continue;
+				}
+
+			// every later write to this address up to a broadcast write, except
+			// for an ID with a write to another address in between, which must
+			// not be overtaken and goes out with a later packet
+			int param[CommandQueue::CAPACITY * 3];
+			bool blocked[ID_BROADCAST];
+			int number = 0;
+			memset(blocked, 0, sizeof(blocked));
+			for (int j = i; j < num; j++)
+				{
+					if (done[j] == true)
+						continue;
+					if (command[j].id == ID_BROADCAST)
+						break;
+					if (command[j].address != address || command[j].length != length)
+						{
+							blocked[command[j].id] = true;
+							continue;
+						}
+					if (blocked[command[j].id] == true)
+						continue;
+
+					int k = 0;
+					while (k < number && param[k * (length + 1)] != command[j].id)
+						k++;
+					if (k == number)
+						number++;
+
+					param[k * (length + 1)] = command[j].id;
+					param[k * (length + 1) + 1] = GetLowByte(command[j].value);
+					if (length == 2)
+						param[k * (length + 1) + 2] = GetHighByte(command[j].value);
+					done[j] = true;
+				}
+
+			if (QueueSyncWrite(address, length + 1, number, param) != SUCCESS)
+				{
+					m_Commands.AddOverflow(number);
+					res = TX_CORRUPT;
+				}
+		}
+
+	return res;
+}
+
+int ArbotixPro::FlushSyncWrite(bool bulk_read)
+{
+	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
+	int res = TX_FAIL;
+	int sync_length = m_TxQueueLength;
+	int length = m_TxQueueLength;
+	int n;
+
+	if (length == 0 && bulk_read == false)
+		return SUCCESS;
+
+	// with a bulk read the bus stays busy with the response after the write returns
+	m_Platform->AcquireBus(0, bulk_read == true ? m_BulkReadTime : GetTransferTime(length));
+
+	if (m_BulkReadPending == true)
+		RxBulkReadPacket(m_BulkReadTxPacket, rxpacket, m_Platform->GetCurrentTime());
+
+	if (bulk_read == true)
+		{
+			if (m_FeedbackChanged == true || m_BulkReadTxPacket[LENGTH] == 0)
+				MakeBulkReadPacket();
+			ScheduleSlowFeedback();
+
+			// the bulk read request follows in the same port write
+			m_BulkReadTxPacket[0] = 0xFF;
+			m_BulkReadTxPacket[1] = 0xFF;
+			m_BulkReadTxPacket[m_BulkReadTxPacket[LENGTH] + 3] = CalculateChecksum(m_BulkReadTxPacket);
+			if (m_Protocol == PROTOCOL_2)
+				n = MakeProtocol2Packet(m_BulkReadTxPacket, &m_TxQueue[length]);
+			else
+				{
+					for (n = 0; n < m_BulkReadTxPacket[LENGTH] + 4; n++)
+						m_TxQueue[length + n] = m_BulkReadTxPacket[n];
+				}
+			m_BulkReadTxLength = n;
+			length += n;
+		}
+
+	if (DEBUG_PRINT == true)
+		{
+			fprintf(stderr, "\nTX: ");
+			for (n = 0; n < length; n++)
+				fprintf(stderr, "%.2X ", m_TxQueue[n]);
+			fprintf(stderr, "INST: SYNC_WRITE%s\n", bulk_read == true ? " + BULK_READ" : "");
+		}
+
+	m_Platform->ClearPort();
+	double start = m_Platform->GetCurrentTime();
+	if (WritePort(m_TxQueue, length) == length)
+		{
+			if (bulk_read == true)
+				{
+					m_SensorTime = start;
+					m_BulkReadPending = true;
+					m_BulkReadDrained = false;
+				}
+			res = SUCCESS;
+		}
+	if (sync_length > 0)
+		m_Statistics.Record(BusStatistics::SYNC_WRITE, ID_BROADCAST, res, sync_length, 0, m_Platform->GetCurrentTime() - start);
+	m_TxQueueLength = 0;
+
+	m_Platform->ReleaseBus(0);
+
+	return res;
+}
+
+int ArbotixPro::CollectBulkRead()
+{
+	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
+	int res = SUCCESS;
+
+	m_Platform->AcquireBus(0, 0);
+	if (m_BulkReadPending == true)
+		res = RxBulkReadPacket(m_BulkReadTxPacket, rxpacket, m_Platform->GetCurrentTime());
+	m_Platform->ReleaseBus(0);
+
+	return res;
+}
+
 int ArbotixPro::SyncWrite(int start_addr, int each_length, int number, int *pParam)
 {
 	unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
@@ -501,18 +1636,32 @@ bool ArbotixPro::ChangeBaud(int baud)
 			fprintf(stderr, "\n Fail to change baudrate\n");
 			return false;
 		}
+	m_Baudrate = 2000000.0 / (double)(baud + 1);
+	m_FeedbackChanged = true;
 
 	return DXLPowerOn();
 }
 
 bool ArbotixPro::DXLPowerOn(bool state)
 {
+	int value;
+
+	// a plain chain is powered from outside
+	if (m_HasBoard == false)
+		return true;
+
+	// the servos keep running, their control tables are still valid
+	if (state == true && ReadByte(ArbotixPro::ID_CM, ArbotixPro::P_DXL_POWER, &value, 0) == ArbotixPro::SUCCESS && value == 1)
+		return true;
+
 	if (WriteByte(ArbotixPro::ID_CM, ArbotixPro::P_DXL_POWER, state == true ? 1 : 0, 0) == ArbotixPro::SUCCESS)
 		{
 			if (DEBUG_PRINT == true)
 				fprintf(stderr, " Succeed to change Dynamixel power!\n");
 
-			m_Platform->Sleep(300); // about 300msec
+			// the servos come back with their power-on control tables
+			m_Shadow.Reset();
+			m_Platform->Sleep(m_PowerOnSettleTime);
 		}
 	else
 		{
@@ -524,11 +1673,24 @@ bool ArbotixPro::DXLPowerOn(bool state)
 	return true;
 }
 
+bool ArbotixPro::DXLPowerCycle()
+{
+	// DXLPowerOn() leaves a bus that is already powered alone
+	if (DXLPowerOn(false) == false)
+		return false;
+
+	return DXLPowerOn(true);
+}
+
 void ArbotixPro::Disconnect()
 {
 // do action upon disconnect
 	unsigned char txpacket[] = {0xFF, 0xFF, 0xC8, 0x05, 0x03, 0x1A, 0xE0, 0x03, 0x32};
-	m_Platform->WritePort(txpacket, 9);
+	unsigned char packet[MAXNUM_TXPACKET];
+	if (m_Protocol == PROTOCOL_2)
+		WritePort(packet, MakeProtocol2Packet(txpacket, packet));
+	else
+		WritePort(txpacket, 9);
 
 	m_Platform->ClosePort();
 }
@@ -543,17 +1705,40 @@ int ArbotixPro::WriteWord(int address, int value, int *error)
 	return WriteWord(ID_CM, address, value, error);
 }
 
-void ArbotixPro::WriteWordDelayed(int address, int value)
+bool ArbotixPro::WriteByteDelayed(int address, int value)
+{
+	return WriteByteDelayed(ID_CM, address, value);
+}
+
+bool ArbotixPro::WriteWordDelayed(int address, int value)
+{
+	return WriteWordDelayed(ID_CM, address, value);
+}
+
+bool ArbotixPro::WriteByteDelayed(int id, int address, int value)
+{
+	return m_Commands.Push(id, address, 1, value);
+}
+
+bool ArbotixPro::WriteWordDelayed(int id, int address, int value)
+{
+	return m_Commands.Push(id, address, 2, value);
+}
+
+bool ArbotixPro::WriteDelayed(int number, int *id, int address, int length, int *value)
 {
-	if (m_DelayedWords > 9) return;
+	bool res = true;
 
-	m_DelayedWord[m_DelayedWords] = value;
-	m_DelayedAddress[m_DelayedWords] = address;
-	m_DelayedWords++;
-	return;
+	for (int i = 0; i < number; i++)
+		{
+			if (m_Commands.Push(id[i], address, length, value[i]) == false)
+				res = false;
+		}
+
+	return res;
 }
 
-int ArbotixPro::Ping(int id, int *error)
+int ArbotixPro::Ping(int id, int *error, int priority)
 {
 	unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
 	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
@@ -563,7 +1748,7 @@ int ArbotixPro::Ping(int id, int *error)
 	txpacket[INSTRUCTION]  = INST_PING;
 	txpacket[LENGTH]       = 2;
 
-	result = TxRxPacket(txpacket, rxpacket, 2);
+	result = TxRxPacket(txpacket, rxpacket, priority);
 	if (result == SUCCESS && txpacket[ID] != ID_BROADCAST)
 		{
 			if (error != 0)
@@ -620,6 +1805,225 @@ int ArbotixPro::ReadWord(int id, int address, int *pValue, int *error)
 	return result;
 }
 
+int ArbotixPro::ReadByte(int id, int address, int *pValue, int *error, double max_age)
+{
+	unsigned char value;
+
+	if (m_Shadow.Read(id, address, &value, 1, m_Platform->GetCurrentTime() - max_age) == false)
+		return ReadByte(id, address, pValue, error);
+
+	*pValue = (int)value;
+	if (error != 0)
+		*error = 0;
+
+	return SUCCESS;
+}
+
+int ArbotixPro::ReadWord(int id, int address, int *pValue, int *error, double max_age)
+{
+	unsigned char value[2];
+
+	if (m_Shadow.Read(id, address, value, 2, m_Platform->GetCurrentTime() - max_age) == false)
+		return ReadWord(id, address, pValue, error);
+
+	*pValue = MakeWord((int)value[0], (int)value[1]);
+	if (error != 0)
+		*error = 0;
+
+	return SUCCESS;
+}
+
+int ArbotixPro::RefreshShadow(int number, int *id, int start_addr, int end_addr, double max_age)
+{
+	unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
+	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
+	unsigned char table[ShadowTable::NUM_ADDRESS];
+	int length = end_addr - start_addr + 1;
+	double since = m_Platform->GetCurrentTime() - max_age;
+	int n = 0;
+
+	if (length <= 0 || start_addr + length > MAXNUM_TABLE)
+		return TX_CORRUPT;
+
+	txpacket[ID]           = (unsigned char)ID_BROADCAST;
+	txpacket[INSTRUCTION]  = INST_BULK_READ;
+	txpacket[PARAMETER]    = (unsigned char)0x0;
+
+	for (int i = 0; i < number; i++)
+		{
+			if (m_Shadow.Read(id[i], start_addr, table, length, since) == true)
+				continue;
+			if (3 * (n + 1) + 1 > MAXNUM_TXPARAM)
+				break;
+
+			txpacket[PARAMETER + 3 * n + 1] = (unsigned char)length;
+			txpacket[PARAMETER + 3 * n + 2] = (unsigned char)id[i];
+			txpacket[PARAMETER + 3 * n + 3] = (unsigned char)start_addr;
+			n++;
+		}
+
+	if (n == 0)
+		return SUCCESS;
+
+	txpacket[LENGTH] = (unsigned char)(3 * n + 3);
+
+	return TxRxPacket(txpacket, rxpacket, 2);
+}
+
+#define NUM_POSE_FIELDS		(8)
+static const int PoseField[NUM_POSE_FIELDS][3] =
+{
+	{ ArbotixPro::POSE_TORQUE,			AXDXL::P_TORQUE_ENABLE,			1 },
+	{ ArbotixPro::POSE_SLOPE,			AXDXL::P_CW_COMPLIANCE_SLOPE,	1 },
+	{ ArbotixPro::POSE_GOAL,			AXDXL::P_GOAL_POSITION_L,		2 },
+	{ ArbotixPro::FEEDBACK_POSITION,	AXDXL::P_PRESENT_POSITION_L,	2 },
+	{ ArbotixPro::FEEDBACK_SPEED,		AXDXL::P_PRESENT_SPEED_L,		2 },
+	{ ArbotixPro::FEEDBACK_LOAD,		AXDXL::P_PRESENT_LOAD_L,		2 },
+	{ ArbotixPro::FEEDBACK_VOLTAGE,		AXDXL::P_PRESENT_VOLTAGE,		1 },
+	{ ArbotixPro::FEEDBACK_TEMPERATURE,	AXDXL::P_PRESENT_TEMPERATURE,	1 }
+};
+
+int ArbotixPro::CapturePose(int number, int *id, int fields, Pose *pose)
+{
+	unsigned char table[ShadowTable::NUM_ADDRESS];
+	int start_addr = -1;
+	int end_addr = -1;
+
+	// one contiguous block from the first to the last requested field
+	for (int i = 0; i < NUM_POSE_FIELDS; i++)
+		{
+			if ((fields & PoseField[i][0]) == 0)
+				continue;
+			if (start_addr < 0)
+				start_addr = PoseField[i][1];
+			end_addr = PoseField[i][1] + PoseField[i][2] - 1;
+		}
+
+	if (start_addr < 0)
+		return SUCCESS;
+
+	double start = m_Platform->GetCurrentTime();
+	int res = RefreshShadow(number, id, start_addr, end_addr, 0.0);
+
+	// the joints that answered have every byte of the block fresh
+	for (int i = 0; i < number; i++)
+		{
+			int n = id[i];
+			if (n < 0 || n >= JointData::NUMBER_OF_JOINTS)
+				continue;
+
+			pose->valid[n] = m_Shadow.Read(n, start_addr, &table[start_addr], end_addr - start_addr + 1, start);
+			if (pose->valid[n] == false)
+				continue;
+
+			if (fields & POSE_TORQUE)
+				pose->torque[n] = table[AXDXL::P_TORQUE_ENABLE];
+			if (fields & POSE_SLOPE)
+				pose->slope[n] = table[AXDXL::P_CW_COMPLIANCE_SLOPE];
+			if (fields & POSE_GOAL)
+				pose->goal[n] = MakeWord(table[AXDXL::P_GOAL_POSITION_L], table[AXDXL::P_GOAL_POSITION_H]);
+			if (fields & FEEDBACK_POSITION)
+				pose->position[n] = MakeWord(table[AXDXL::P_PRESENT_POSITION_L], table[AXDXL::P_PRESENT_POSITION_H]);
+			if (fields & FEEDBACK_SPEED)
+				pose->speed[n] = MakeWord(table[AXDXL::P_PRESENT_SPEED_L], table[AXDXL::P_PRESENT_SPEED_H]);
+			if (fields & FEEDBACK_LOAD)
+				pose->load[n] = MakeWord(table[AXDXL::P_PRESENT_LOAD_L], table[AXDXL::P_PRESENT_LOAD_H]);
+			if (fields & FEEDBACK_VOLTAGE)
+				pose->voltage[n] = table[AXDXL::P_PRESENT_VOLTAGE];
+			if (fields & FEEDBACK_TEMPERATURE)
+				pose->temperature[n] = table[AXDXL::P_PRESENT_TEMPERATURE];
+		}
+
+	return res;
+}
+
+int ArbotixPro::ApplyPose(int number, int *id, int *position, int *slope, int torque)
+{
+	unsigned char txpacket[MAXNUM_TXPARAM + 10];
+	unsigned char queue[2 * MAXNUM_TXPACKET];
+	int length = 0;
+	int res = TX_FAIL;
+	int n;
+
+	// the slopes sit right before the goal position: CW, CCW, goal L, goal H
+	int start_addr = (slope != 0) ? AXDXL::P_CW_COMPLIANCE_SLOPE : AXDXL::P_GOAL_POSITION_L;
+	int end_addr = (position != 0) ? AXDXL::P_GOAL_POSITION_H : AXDXL::P_CCW_COMPLIANCE_SLOPE;
+	int each_length = end_addr - start_addr + 2;
+
+	if (number <= 0)
+		return SUCCESS;
+	if (number * each_length + 8 >= MAXNUM_TXPARAM + 6)
+		return TX_CORRUPT;
+
+	if (position != 0 || slope != 0)
+		{
+			txpacket[ID]                = (unsigned char)ID_BROADCAST;
+			txpacket[INSTRUCTION]       = INST_SYNC_WRITE;
+			txpacket[PARAMETER]			= (unsigned char)start_addr;
+			txpacket[PARAMETER + 1]		= (unsigned char)(each_length - 1);
+			n = PARAMETER + 2;
+			for (int i = 0; i < number; i++)
+				{
+					txpacket[n++] = (unsigned char)id[i];
+					if (slope != 0)
+						{
+							txpacket[n++] = (unsigned char)slope[i];
+							txpacket[n++] = (unsigned char)slope[i];
+						}
+					if (position != 0)
+						{
+							txpacket[n++] = (unsigned char)GetLowByte(position[i]);
+							txpacket[n++] = (unsigned char)GetHighByte(position[i]);
+						}
+				}
+			txpacket[LENGTH]            = n - PARAMETER + 2;
+			length += AppendPacket(txpacket, queue, length);
+		}
+
+	// after the goal, which turns the torque on by itself
+	if (torque >= 0)
+		{
+			txpacket[ID]                = (unsigned char)ID_BROADCAST;
+			txpacket[INSTRUCTION]       = INST_SYNC_WRITE;
+			txpacket[PARAMETER]			= (unsigned char)AXDXL::P_TORQUE_ENABLE;
+			txpacket[PARAMETER + 1]		= 1;
+			n = PARAMETER + 2;
+			for (int i = 0; i < number; i++)
+				{
+					txpacket[n++] = (unsigned char)id[i];
+					txpacket[n++] = (unsigned char)torque;
+				}
+			txpacket[LENGTH]            = n - PARAMETER + 2;
+			length += AppendPacket(txpacket, queue, length);
+		}
+
+	if (length == 0)
+		return SUCCESS;
+
+	m_Platform->AcquireBus(1, GetTransferTime(length));
+
+	if (m_BulkReadPending == true)
+		DrainBulkRead();
+
+	if (DEBUG_PRINT == true)
+		{
+			fprintf(stderr, "\nTX: ");
+			for (n = 0; n < length; n++)
+				fprintf(stderr, "%.2X ", queue[n]);
+			fprintf(stderr, "INST: SYNC_WRITE\n");
+		}
+
+	m_Platform->ClearPort();
+	double start = m_Platform->GetCurrentTime();
+	if (WritePort(queue, length) == length)
+		res = SUCCESS;
+	m_Statistics.Record(BusStatistics::SYNC_WRITE, ID_BROADCAST, res, length, 0, m_Platform->GetCurrentTime() - start);
+
+	m_Platform->ReleaseBus(1);
+
+	return res;
+}
+
 int ArbotixPro::ReadTable(int id, int start_addr, int end_addr, unsigned char *table, int *error)
 {
 	unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
@@ -646,7 +2050,7 @@ int ArbotixPro::ReadTable(int id, int start_addr, int end_addr, unsigned char *t
 	return result;
 }
 
-int ArbotixPro::WriteByte(int id, int address, int value, int *error)
+int ArbotixPro::WriteByte(int id, int address, int value, int *error, int priority)
 {
 	unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
 	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
@@ -658,7 +2062,7 @@ int ArbotixPro::WriteByte(int id, int address, int value, int *error)
 	txpacket[PARAMETER + 1]  = (unsigned char)value;
 	txpacket[LENGTH]       = 4;
 
-	result = TxRxPacket(txpacket, rxpacket, 2);
+	result = TxRxPacket(txpacket, rxpacket, priority);
 	if (result == SUCCESS && id != ID_BROADCAST)
 		{
 			if (error != 0)
@@ -668,7 +2072,7 @@ int ArbotixPro::WriteByte(int id, int address, int value, int *error)
 	return result;
 }
 
-int ArbotixPro::WriteWord(int id, int address, int value, int *error)
+int ArbotixPro::WriteWord(int id, int address, int value, int *error, int priority)
 {
 	unsigned char txpacket[MAXNUM_TXPARAM + 10] = {0, };
 	unsigned char rxpacket[MAXNUM_RXPARAM + 10] = {0, };
@@ -681,7 +2085,7 @@ int ArbotixPro::WriteWord(int id, int address, int value, int *error)
 	txpacket[PARAMETER + 2]  = (unsigned char)GetHighByte(value);
 	txpacket[LENGTH]       = 5;
 
-	result = TxRxPacket(txpacket, rxpacket, 2);
+	result = TxRxPacket(txpacket, rxpacket, priority);
 	if (result == SUCCESS && id != ID_BROADCAST)
 		{
 			if (error != 0)
@@ -0,0 +1,144 @@
+/*
+ *   BusStatistics.cpp
+ *
+ *   Per-instruction and per-device counters of the Dynamixel bus
+ *
+ */
+#include "ArbotixPro.h"
+#include "BusStatistics.h"
+
+using namespace Robot;
+
+
+BusStatistics::Entry::Entry()
+{
+	Reset();
+}
+
+void BusStatistics::Entry::Reset()
+{
+	count = 0;
+	timeout = 0;
+	corrupt = 0;
+	fail = 0;
+	tx_bytes = 0;
+	rx_bytes = 0;
+	latency.Reset();
+}
+
+BusStatistics::BusStatistics()
+{
+}
+
+static void Count(BusStatistics::Entry *entry, int result)
+{
+	entry->count++;
+	if (result == ArbotixPro::RX_TIMEOUT)
+		entry->timeout++;
+	else if (result == ArbotixPro::RX_CORRUPT || result == ArbotixPro::RX_FAIL)
+		entry->corrupt++;
+	else if (result == ArbotixPro::TX_FAIL || result == ArbotixPro::TX_CORRUPT)
+		entry->fail++;
+}
+
+void BusStatistics::Record(int instruction, int id, int result, int tx_bytes, int rx_bytes, double latency)
+{
+	Entry *entry = &m_Instruction[instruction];
+
+	Count(entry, result);
+	entry->tx_bytes += tx_bytes;
+	entry->rx_bytes += rx_bytes;
+	entry->latency.Add(latency);
+
+	if (id >= 0 && id < NUM_DEVICE)
+		{
+			entry = &m_Device[id];
+			Count(entry, result);
+			entry->tx_bytes += tx_bytes;
+			entry->rx_bytes += rx_bytes;
+			entry->latency.Add(latency);
+		}
+}
+
+void BusStatistics::RecordDevice(int id, int result, int rx_bytes)
+{
+	if (id < 0 || id >= NUM_DEVICE)
+		return;
+
+	Count(&m_Device[id], result);
+	m_Device[id].rx_bytes += rx_bytes;
+}
+
+void BusStatistics::Reset()
+{
+	for (int i = 0; i < NUM_INSTRUCTION; i++)
+		m_Instruction[i].Reset();
+	for (int id = 0; id < NUM_DEVICE; id++)
+		m_Device[id].Reset();
+}
+
+unsigned long BusStatistics::GetTxBytes()
+{
+	unsigned long bytes = 0;
+	for (int i = 0; i < NUM_INSTRUCTION; i++)
+		bytes += m_Instruction[i].tx_bytes;
+	return bytes;
+}
+
+unsigned long BusStatistics::GetRxBytes()
+{
+	unsigned long bytes = 0;
+	for (int i = 0; i < NUM_INSTRUCTION; i++)
+		bytes += m_Instruction[i].rx_bytes;
+	return bytes;
+}
+
+const char* BusStatistics::GetInstructionName(int instruction)
+{
+	switch (instruction)
+		{
+		case PING:
+			return "PING";
+		case READ:
+			return "READ";
+		case WRITE:
+			return "WRITE";
+		case SYNC_WRITE:
+			return "SYNC_WRITE";
+		case BULK_READ:
+			return "BULK_READ";
+		default:
+			return "OTHER";
+		}
+}
+
+void BusStatistics::Print(FILE *fp)
+{
+	fprintf(fp, "\n %-11s %8s %8s %8s %6s %10s %10s %8s %8s %8s\n",
+	        "INSTRUCTION", "COUNT", "TIMEOUT", "CORRUPT", "FAIL", "TX BYTES", "RX BYTES", "AVG(ms)", "P99(ms)", "MAX(ms)");
+	for (int i = 0; i < NUM_INSTRUCTION; i++)
+		{
+			Entry *entry = &m_Instruction[i];
+			if (entry->count == 0)
+				continue;
+			fprintf(fp, " %-11s %8u %8u %8u %6u %10lu %10lu %8.3f %8.3f %8.3f\n",
+			        GetInstructionName(i), entry->count, entry->timeout, entry->corrupt, entry->fail,
+			        entry->tx_bytes, entry->rx_bytes,
+			        entry->latency.GetMean(), entry->latency.GetPercentile(0.99), entry->latency.GetMax());
+		}
+
+	fprintf(fp, "\n %-11s %8s %8s %8s %6s %10s %10s %8s %8s %8s\n",
+	        "ID", "COUNT", "TIMEOUT", "CORRUPT", "FAIL", "TX BYTES", "RX BYTES", "AVG(ms)", "P99(ms)", "MAX(ms)");
+	for (int id = 0; id < NUM_DEVICE; id++)
+		{
+			Entry *entry = &m_Device[id];
+			if (entry->count == 0)
+				continue;
+			fprintf(fp, " %-11d %8u %8u %8u %6u %10lu %10lu %8.3f %8.3f %8.3f\n",
+			        id, entry->count, entry->timeout, entry->corrupt, entry->fail,
+			        entry->tx_bytes, entry->rx_bytes,
+			        entry->latency.GetMean(), entry->latency.GetPercentile(0.99), entry->latency.GetMax());
+		}
+
+	fprintf(fp, "\n Bytes on the wire: TX %lu, RX %lu\n\n", GetTxBytes(), GetRxBytes());
+}
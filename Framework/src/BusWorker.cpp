@@ -0,0 +1,118 @@
+/*
+ *   BusWorker.cpp
+ *
+ *   I/O thread doing the per-tick transactions of one Dynamixel chain
+ *
+ */
+#include "BusWorker.h"
+
+using namespace Robot;
+
+
+BusWorker::BusWorker(ArbotixPro *arbotixpro)
+{
+	m_ArbotixPro = arbotixpro;
+	m_Job = 0;
+	m_Busy = false;
+	m_Running = false;
+	pthread_mutex_init(&m_Mutex, 0);
+	pthread_cond_init(&m_Cond, 0);
+}
+
+BusWorker::~BusWorker()
+{
+	Stop();
+	pthread_cond_destroy(&m_Cond);
+	pthread_mutex_destroy(&m_Mutex);
+}
+
+bool BusWorker::Start()
+{
+	if (m_Running == true)
+		return true;
+
+	m_Running = true;
+	if (pthread_create(&m_Thread, 0, ThreadProc, this) != 0)
+		{
+			m_Running = false;
+			return false;
+		}
+
+	return true;
+}
+
+void BusWorker::Stop()
+{
+	if (m_Running == false)
+		return;
+
+	pthread_mutex_lock(&m_Mutex);
+	m_Running = false;
+	pthread_cond_broadcast(&m_Cond);
+	pthread_mutex_unlock(&m_Mutex);
+
+	pthread_join(m_Thread, 0);
+}
+
+void BusWorker::Post(int job)
+{
+	// without the thread the job is done right away
+	if (m_Running == false)
+		{
+			Run(m_ArbotixPro, job);
+			return;
+		}
+
+	pthread_mutex_lock(&m_Mutex);
+	while (m_Busy == true)
+		pthread_cond_wait(&m_Cond, &m_Mutex);
+	m_Job = job;
+	m_Busy = true;
+	pthread_cond_broadcast(&m_Cond);
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+void BusWorker::Wait()
+{
+	pthread_mutex_lock(&m_Mutex);
+	while (m_Busy == true)
+		pthread_cond_wait(&m_Cond, &m_Mutex);
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+void BusWorker::Run(ArbotixPro *arbotixpro, int job)
+{
+	if (job & JOB_COLLECT)
+		arbotixpro->CollectBulkRead();
+	if (job & JOB_FLUSH)
+		arbotixpro->FlushSyncWrite();
+	if (job & JOB_FLUSH_BULK_READ)
+		arbotixpro->FlushSyncWrite(true);
+	if (job & JOB_BULK_READ)
+		arbotixpro->BulkRead();
+}
+
+void* BusWorker::ThreadProc(void *param)
+{
+	BusWorker *worker = (BusWorker*)param;
+
+	pthread_mutex_lock(&worker->m_Mutex);
+	while (1)
+		{
+			while (worker->m_Busy == false && worker->m_Running == true)
+				pthread_cond_wait(&worker->m_Cond, &worker->m_Mutex);
+			if (worker->m_Running == false)
+				break;
+
+			int job = worker->m_Job;
+			pthread_mutex_unlock(&worker->m_Mutex);
+			Run(worker->m_ArbotixPro, job);
+			pthread_mutex_lock(&worker->m_Mutex);
+
+			worker->m_Busy = false;
+			pthread_cond_broadcast(&worker->m_Cond);
+		}
+	pthread_mutex_unlock(&worker->m_Mutex);
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ *   CommandQueue.cpp
+ *
+ *   Bounded lock-free queue of control table writes
+ *
+ */
+#include "CommandQueue.h"
+
+using namespace Robot;
+
+
+CommandQueue::CommandQueue()
+{
+	for (unsigned int i = 0; i < CAPACITY; i++)
+		m_Cell[i].sequence = i;
+	m_Head = 0;
+	m_Tail = 0;
+	m_Overflow = 0;
+}
+
+bool CommandQueue::Push(int id, int address, int length, int value)
+{
+	unsigned int pos = m_Head;
+	Cell *cell;
+
+	while (1)
+		{
+			cell = &m_Cell[pos & (CAPACITY - 1)];
+			unsigned int sequence = cell->sequence;
+			__sync_synchronize();
+
+			int diff = (int)(sequence - pos);
+			if (diff == 0)
+				{
+					// the cell is free for this position, claim it
+					if (__sync_bool_compare_and_swap(&m_Head, pos, pos + 1) == true)
+						break;
+				}
+			else if (diff < 0)
+				{
+					// not popped yet since the last lap, the queue is full
+					__sync_fetch_and_add(&m_Overflow, 1);
+					return false;
+				}
+			pos = m_Head;
+		}
+
+	cell->command.id = id;
+	cell->command.address = address;
+	cell->command.length = length;
+	cell->command.value = value;
+	__sync_synchronize();
+	cell->sequence = pos + 1;
+
+	return true;
+}
+
+bool CommandQueue::Pop(Command *command)
+{
+	Cell *cell = &m_Cell[m_Tail & (CAPACITY - 1)];
+	unsigned int sequence = cell->sequence;
+	__sync_synchronize();
+
+	// claimed by a producer that is not done writing, or empty
+	if (sequence != m_Tail + 1)
+		return false;
+
+	*command = cell->command;
+	__sync_synchronize();
+	cell->sequence = m_Tail + CAPACITY;
+	m_Tail++;
+
+	return true;
+}
@@ -0,0 +1,99 @@
+/*
+ *   PacketCapture.cpp
+ *
+ *   Lock-free ring of the raw bytes sent and received on the Dynamixel bus
+ *
+ */
+#include <string.h>
+#include "PacketCapture.h"
+
+using namespace Robot;
+
+
+const char PacketCapture::MAGIC[8] = { 'D', 'X', 'L', 'T', 'R', 'A', 'C', 'E' };
+
+PacketCapture::PacketCapture()
+{
+	m_Head = 0;
+	m_Tail = 0;
+	m_Dropped = 0;
+}
+
+PacketCapture::~PacketCapture()
+{
+}
+
+void PacketCapture::Copy(unsigned int position, const unsigned char *data, int length)
+{
+	unsigned int offset = position & (RING_SIZE - 1);
+	unsigned int first = RING_SIZE - offset;
+
+	if (first > (unsigned int)length)
+		first = length;
+	memcpy(&m_Ring[offset], data, first);
+	memcpy(&m_Ring[0], data + first, length - first);
+}
+
+void PacketCapture::Add(int direction, int protocol, double time, const unsigned char *data, int length)
+{
+	unsigned long long nsec = (unsigned long long)(time * 1000000.0);
+	unsigned char header[HEADER_SIZE];
+	unsigned int head = m_Head;
+
+	if (length <= 0 || length > 0xFFFF || head + HEADER_SIZE + length - m_Tail > RING_SIZE)
+		{
+			__sync_fetch_and_add(&m_Dropped, 1);
+			return;
+		}
+
+	for (int i = 0; i < 8; i++)
+		header[i] = (unsigned char)(nsec >> (8 * i));
+	header[8] = (unsigned char)(length & 0xFF);
+	header[9] = (unsigned char)(length >> 8);
+	header[10] = (unsigned char)direction;
+	header[11] = (unsigned char)protocol;
+
+	Copy(head, header, HEADER_SIZE);
+	Copy(head + HEADER_SIZE, data, length);
+
+	// the record is complete before the consumer can see it
+	__sync_synchronize();
+	m_Head = head + HEADER_SIZE + length;
+}
+
+int PacketCapture::Drain(unsigned char *buffer, int size)
+{
+	unsigned int tail = m_Tail;
+	unsigned int head = m_Head;
+	int copied = 0;
+
+	__sync_synchronize();
+
+	while (tail != head)
+		{
+			int length = m_Ring[(tail + 8) & (RING_SIZE - 1)] | (m_Ring[(tail + 9) & (RING_SIZE - 1)] << 8);
+			int record = HEADER_SIZE + length;
+			if (copied + record > size)
+				break;
+
+			for (int i = 0; i < record; i++)
+				buffer[copied + i] = m_Ring[(tail + i) & (RING_SIZE - 1)];
+			copied += record;
+			tail += record;
+		}
+
+	// the space is given back only after the bytes were read
+	__sync_synchronize();
+	m_Tail = tail;
+
+	return copied;
+}
+
+void PacketCapture::MakeFileHeader(unsigned char *header)
+{
+	memcpy(header, MAGIC, sizeof(MAGIC));
+	header[8] = (unsigned char)(VERSION & 0xFF);
+	header[9] = (unsigned char)((VERSION >> 8) & 0xFF);
+	header[10] = 0;
+	header[11] = 0;
+}
@@ -0,0 +1,127 @@
+/*
+ *   ShadowTable.cpp
+ *
+ *   Per-device copy of the control tables with the age of every byte
+ *
+ */
+#include "ShadowTable.h"
+
+using namespace Robot;
+
+
+ShadowTable::ShadowTable()
+{
+	for (int id = 0; id < NUM_DEVICE; id++)
+		{
+			m_Device[id].sequence = 0;
+			m_Device[id].present = false;
+			for (int i = 0; i < NUM_ADDRESS; i++)
+				{
+					m_Device[id].table[i] = 0;
+					m_Device[id].time[i] = 0.0;
+				}
+		}
+}
+
+void ShadowTable::Lock(Device *dev)
+{
+	while (1)
+		{
+			unsigned int sequence = dev->sequence;
+			if ((sequence & 1) == 0 && __sync_bool_compare_and_swap(&dev->sequence, sequence, sequence + 1) == true)
+				break;
+		}
+}
+
+void ShadowTable::Unlock(Device *dev)
+{
+	__sync_synchronize();
+	dev->sequence = dev->sequence + 1;
+}
+
+void ShadowTable::Store(int id, int address, const unsigned char *data, int length, double time, bool answered)
+{
+	if (id < 0 || id >= NUM_DEVICE || address < 0 || length <= 0 || address + length > NUM_ADDRESS)
+		return;
+
+	Device *dev = &m_Device[id];
+	Lock(dev);
+	if (answered == true || dev->present == true)
+		{
+			dev->present = true;
+			for (int i = 0; i < length; i++)
+				{
+					dev->table[address + i] = data[i];
+					dev->time[address + i] = time;
+				}
+		}
+	Unlock(dev);
+}
+
+void ShadowTable::Update(int id, int address, const unsigned char *data, int length, double time)
+{
+	Store(id, address, data, length, time, true);
+}
+
+void ShadowTable::Write(int id, int address, const unsigned char *data, int length, double time)
+{
+	Store(id, address, data, length, time, false);
+}
+
+void ShadowTable::Invalidate(int id)
+{
+	if (id < 0 || id >= NUM_DEVICE)
+		return;
+
+	Device *dev = &m_Device[id];
+	Lock(dev);
+	dev->present = false;
+	for (int i = 0; i < NUM_ADDRESS; i++)
+		dev->time[i] = 0.0;
+	Unlock(dev);
+}
+
+void ShadowTable::Reset()
+{
+	for (int id = 0; id < NUM_DEVICE; id++)
+		Invalidate(id);
+}
+
+bool ShadowTable::Read(int id, int address, unsigned char *data, int length, double since)
+{
+	if (id < 0 || id >= NUM_DEVICE || address < 0 || length <= 0 || address + length > NUM_ADDRESS)
+		return false;
+
+	Device *dev = &m_Device[id];
+	bool fresh;
+
+	while (1)
+		{
+			unsigned int sequence = dev->sequence;
+			if ((sequence & 1) != 0)
+				continue;
+			__sync_synchronize();
+
+			fresh = dev->present;
+			for (int i = 0; i < length; i++)
+				{
+					data[i] = dev->table[address + i];
+					if (dev->time[address + i] <= 0.0 || dev->time[address + i] < since)
+						fresh = false;
+				}
+
+			__sync_synchronize();
+			if (dev->sequence == sequence)
+				break;
+		}
+
+	return fresh;
+}
+
+bool ShadowTable::IsPresent(int id)
+{
+	if (id < 0 || id >= NUM_DEVICE)
+		return false;
+
+	return m_Device[id].present;
+}
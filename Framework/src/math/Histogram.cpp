@@ -0,0 +1,71 @@
+/*
+ *   Histogram.cpp
+ *
+ *   Fixed-size histogram of timing samples
+ *
+ */
+
+#include "Histogram.h"
+
+using namespace Robot;
+
+
+Histogram::Histogram(double bucket_width)
+{
+	m_BucketWidth = bucket_width;
+	Reset();
+}
+
+void Histogram::Add(double value)
+{
+	int index = (int)(value / m_BucketWidth);
+
+	if (index < 0)
+		index = 0;
+	else if (index >= NUM_BUCKETS)
+		index = NUM_BUCKETS - 1;
+
+	m_Bucket[index]++;
+	if (m_Count == 0 || value < m_Min)
+		m_Min = value;
+	if (m_Count == 0 || value > m_Max)
+		m_Max = value;
+	m_Count++;
+	m_Sum += value;
+}
+
+void Histogram::Reset()
+{
+	for (int i = 0; i < NUM_BUCKETS; i++)
+		m_Bucket[i] = 0;
+	m_Count = 0;
+	m_Sum = 0.0;
+	m_Min = 0.0;
+	m_Max = 0.0;
+}
+
+double Histogram::GetMean()
+{
+	if (m_Count == 0)
+		return 0.0;
+
+	return m_Sum / m_Count;
+}
+
+double Histogram::GetPercentile(double fraction)
+{
+	unsigned int target = (unsigned int)(fraction * m_Count + 0.5);
+	unsigned int sum = 0;
+
+	if (m_Count == 0)
+		return 0.0;
+
+	for (int i = 0; i < NUM_BUCKETS - 1; i++)
+		{
+			sum += m_Bucket[i];
+			if (sum >= target)
+				return ((i + 1) * m_BucketWidth < m_Max) ? (i + 1) * m_BucketWidth : m_Max;
+		}
+
+	return m_Max;
+}
@@ -13,14 +13,21 @@ using namespace Robot;
 
 JointData::JointData()
 {
+    m_EnableMask = 0;
     for (int i = 0; i < NUMBER_OF_JOINTS; i++)
         {
             m_Enable[i] = true;
+            m_EnableMask |= 1u << i;
             m_Value[i] = AXDXL::CENTER_VALUE;
             m_Angle[i] = 0.0;
             m_CWSlope[i] = SLOPE_HARD;
             m_CCWSlope[i] = SLOPE_HARD;
             m_Temp[i] = TEMP_DEFAULT;
+            m_PresentPosition[i] = AXDXL::CENTER_VALUE;
+            m_PresentSpeed[i] = 0;
+            m_PresentLoad[i] = 0;
+            m_Voltage[i] = 0;
+            m_Changed[i] = CHANGED_ALL;
         }
 }
 
@@ -30,7 +37,13 @@ JointData::~JointData()
 
 void JointData::SetEnable(int id, bool enable)
 {
+    if (enable == true && m_Enable[id] == false)
+        m_Changed[id] = CHANGED_ALL;
     m_Enable[id] = enable;
+    if (enable == true)
+        m_EnableMask |= 1u << id;
+    else
+        m_EnableMask &= ~(1u << id);
 }
 
 void JointData::SetEnable(int id, bool enable, bool exclusive)
@@ -39,7 +52,13 @@ void JointData::SetEnable(int id, bool enable, bool exclusive)
 	{
     	MotionManager::GetInstance()->SetJointDisable(id);
 	}
+    if (enable == true && m_Enable[id] == false)
+        m_Changed[id] = CHANGED_ALL;
     m_Enable[id] = enable;
+    if (enable == true)
+        m_EnableMask |= 1u << id;
+    else
+        m_EnableMask &= ~(1u << id);
 }
 
 void JointData::SetEnableHeadOnly(bool enable)
@@ -165,6 +184,8 @@ void JointData::SetValue(int id, int value)
     else if (value >= AXDXL::MAX_VALUE)
         value = AXDXL::MAX_VALUE;
 
+    if (m_Value[id] != value)
+        m_Changed[id] |= CHANGED_VALUE;
     m_Value[id] = value;
     m_Angle[id] = AXDXL::Value2Angle(value);
 }
@@ -182,6 +203,8 @@ void JointData::SetAngle(int id, double angle)
         angle = AXDXL::MAX_ANGLE;
 
     m_Angle[id] = angle;
+    if (m_Value[id] != AXDXL::Angle2Value(angle))
+        m_Changed[id] |= CHANGED_VALUE;
     m_Value[id] = AXDXL::Angle2Value(angle);
 }
 
@@ -208,6 +231,8 @@ void JointData::SetSlope(int id, int cwSlope, int ccwSlope)
 
 void JointData::SetCWSlope(int id, int cwSlope)
 {
+    if (m_CWSlope[id] != cwSlope)
+        m_Changed[id] |= CHANGED_SLOPE;
     m_CWSlope[id] = cwSlope;
 }
 
@@ -218,6 +243,8 @@ int JointData::GetCWSlope(int id)
 
 void JointData::SetCCWSlope(int id, int ccwSlope)
 {
+    if (m_CCWSlope[id] != ccwSlope)
+        m_Changed[id] |= CHANGED_SLOPE;
     m_CCWSlope[id] = ccwSlope;
 }
 
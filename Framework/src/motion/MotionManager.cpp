@@ -6,37 +6,95 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include "FSR.h"
 #include "AXDXL.h"
 #include "MotionManager.h"
 #include <unistd.h>
+#include <time.h>
 #include <assert.h>
 #include <stdlib.h>
 
 using namespace Robot;
 
 // Torque adaption every second
-const int TORQUE_ADAPTION_CYCLES = 1000 / MotionModule::TIME_UNIT;
+const int TORQUE_ADAPTION_TIME = 1000;
 const int DEST_TORQUE = 1023;
+// Unchanged joints are sent every second
+const int FULL_REFRESH_TIME = 1000;
+// Quarantined joints are pinged every 100msec, between the ticks
+const int REPROBE_TIME = 100;
+// The idle period is taken after a second without a goal change
+const int IDLE_TIME = 1000;
+// Share of the period the bus work of a tick may take
+const double BUS_SHARE = 0.75;
 
 //#define LOG_VOLTAGES 1
 
+double MotionModule::PERIOD(MotionModule::TIME_UNIT);
+
 MotionManager* MotionManager::m_UniqueInstance = new MotionManager();
 
+// ticks in the given msec at the current period
+static int Cycles(int msec)
+{
+    int cycles = (int)(msec / MotionModule::PERIOD + 0.5);
+    return (cycles > 0) ? cycles : 1;
+}
+
 MotionManager::MotionManager() :
+    m_NumModules(0),
+    m_NumSlots(0),
+    m_BlendTime(0),
+    m_OwnersChanged(false),
     m_ArbotixPro(0),
     m_ProcessEnable(false),
     m_Enabled(false),
     m_IsRunning(false),
     m_IsThreadRunning(false),
     m_IsLogging(false),
-    m_torqueAdaptionCounter(TORQUE_ADAPTION_CYCLES),
+    m_Pipelined(false),
+    m_RefreshCounter(1),
+    m_Compensate(false),
+    m_LogRecord(0),
+    m_LogCount(0),
+    m_LogDropped(0),
+    m_FadeInStart(0),
+    m_FadeInStep(2),
+    m_FadeInTime(DEST_TORQUE * MotionModule::TIME_UNIT / 2),
+    m_Period(MotionModule::TIME_UNIT),
+    m_IdlePeriod(0),
+    m_IdleTime(0),
+    m_Moved(false),
+    m_BootTimeout(1000),
+    m_NumPorts(1),
+    m_torqueAdaptionCounter(Cycles(TORQUE_ADAPTION_TIME)),
     m_voltageAdaptionFactor(1.0),
+    m_ServiceReady(false),
     DEBUG_PRINT(false)
 {
     for (int i = 0; i < JointData::NUMBER_OF_JOINTS; i++)
-        m_Offset[i] = 0;
+        {
+            m_Offset[i] = 0;
+            m_SentOffset[i] = 0;
+            m_SentValue[i] = 0;
+            m_ServoMap[i] = false;
+            m_JointPort[i] = 0;
+            m_Quarantined[i] = false;
+            m_SlotOf[i] = -1;
+            m_Owner[i] = 0;
+            m_JointBlend[i] = -1;
+        }
+    for (int i = 0; i < MAX_PORTS; i++)
+        m_Worker[i] = 0;
+    for (int i = 0; i < MAX_MODULES; i++)
+        {
+            m_Modules[i] = 0;
+            m_ModuleMask[i] = 0;
+            m_ModuleBlend[i] = -1;
+        }
+    m_LogFile[0] = 0;
 
 #if LOG_VOLTAGES
     assert((m_voltageLog = fopen("voltage.log", "w")));
@@ -46,17 +104,60 @@ MotionManager::MotionManager() :
 
 MotionManager::~MotionManager()
 {
+    delete[] m_LogRecord;
 }
 
-bool MotionManager::Initialize(ArbotixPro *arbotixpro, bool fadeIn)
+// the bus work that may not hold up a tick: pings the quarantined joints
+// in the idle slot between ticks until adaptTorqueToVoltage() posts
+void *MotionManager::ServiceProc(void *param)
 {
-    int value, error;
+    MotionManager *manager = (MotionManager *)param;
+
+    while (1)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += REPROBE_TIME * 1000000L;
+            if (ts.tv_nsec >= 1000000000L)
+                {
+                    ts.tv_sec++;
+                    ts.tv_nsec -= 1000000000L;
+                }
+            if (sem_timedwait(&manager->m_Shutdown, &ts) == 0)
+                break;
 
+            // a port without quarantined joints returns at once
+            for (int port = 0; port < manager->m_NumPorts; port++)
+                manager->GetPort(port)->Reprobe();
+        }
+    manager->m_ArbotixPro->DXLPowerOn(false); //power off bus
+    printf( "MotionManager::adaptTorqueToVoltage: Voltage dropped below safe threshold. Shutting down." );
+    fflush(stdout);
+    system( "poweroff" );
+    return 0;
+}
+
+bool MotionManager::Initialize(ArbotixPro *arbotixpro, bool fadeIn)
+{
     usleep(100);
     m_ArbotixPro = arbotixpro;
+    for (int port = 0; port < m_NumPorts; port++)
+        GetPort(port)->SetRefreshTime(BUS_SHARE * m_Period);
     m_Enabled = false;
     m_ProcessEnable = true;
 
+    if (m_ServiceReady == false)
+        {
+            sem_init(&m_Shutdown, 0, 0);
+            if (pthread_create(&m_ServiceThread, 0, ServiceProc, this) == 0)
+                {
+                    pthread_detach(m_ServiceThread);
+                    m_ServiceReady = true;
+                }
+            else
+                sem_destroy(&m_Shutdown);
+        }
+
     if (m_ArbotixPro->Connect() == false)
         {
             if (DEBUG_PRINT == true)
@@ -64,36 +165,41 @@ bool MotionManager::Initialize(ArbotixPro *arbotixpro, bool fadeIn)
             return false;
         }
 
-    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+    for (int port = 1; port < m_NumPorts; port++)
         {
-            if (DEBUG_PRINT == true)
-                fprintf(stderr, "ID:%d initializing...", id);
-
-            if (m_ArbotixPro->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &value, &error) == ArbotixPro::SUCCESS)
-                {
-                    MotionStatus::m_CurrentJoints.SetValue(id, value);
-                    MotionStatus::m_CurrentJoints.SetEnable(id, true);
-
-                    if (DEBUG_PRINT == true)
-                        fprintf(stderr, "[%d] Success\n", value);
-                }
-            else
+            if (GetPort(port)->Connect() == false || m_Worker[port]->Start() == false)
                 {
-                    MotionStatus::m_CurrentJoints.SetEnable(id, false);
-
                     if (DEBUG_PRINT == true)
-                        fprintf(stderr, " Fail\n");
+                        fprintf(stderr, "Fail to connect port %d\n", port);
+                    return false;
                 }
         }
 
+    AttachJoints();
+    DiscoverJoints();
+
     if (fadeIn)
         {
-            for (int i = JointData::ID_R_SHOULDER_PITCH; i < JointData::NUMBER_OF_JOINTS; i++)
-                arbotixpro->WriteWord(i, AXDXL::P_TORQUE_LIMIT_L, 0, 0);
+            for (int port = 0; port < m_NumPorts; port++)
+                {
+                    int param[JointData::NUMBER_OF_JOINTS * 3];
+                    int n = 0, joint_num = 0;
+                    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+                        {
+                            if (MotionStatus::m_CurrentJoints.GetEnable(id) == false || m_JointPort[id] != port)
+                                continue;
+                            param[n++] = id;
+                            param[n++] = ArbotixPro::GetLowByte(m_FadeInStart);
+                            param[n++] = ArbotixPro::GetHighByte(m_FadeInStart);
+                            joint_num++;
+                        }
+                    if (joint_num > 0)
+                        GetPort(port)->SyncWrite(AXDXL::P_TORQUE_LIMIT_L, 3, joint_num, param);
+                }
         }
 
     m_fadeIn = fadeIn;
-    m_torque_count = 0;
+    m_torque_count = m_FadeInStart;
 
     m_CalibrationStatus = 0;
     m_FBGyroCenter = 512;
@@ -102,43 +208,265 @@ bool MotionManager::Initialize(ArbotixPro *arbotixpro, bool fadeIn)
     return true;
 }
 
+bool MotionManager::Initialize(ArbotixPro *arbotixpro, minIni *ini, bool fadeIn)
+{
+    std::string map = ini->gets(BOOT_SECTION, "servo_map", "");
+    char buffer[128];
+
+    for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+        m_ServoMap[id] = false;
+    strncpy(buffer, map.c_str(), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = 0;
+    for (char *token = strtok(buffer, ","); token != 0; token = strtok(0, ","))
+        {
+            int id = atoi(token);
+            if (id >= JointData::ID_MIN && id <= JointData::ID_MAX)
+                m_ServoMap[id] = true;
+        }
+
+    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+        {
+            char key[10];
+            sprintf(key, "ID_%.2d", id);
+            SetJointPort(id, ini->geti(PORT_SECTION, key, m_JointPort[id]));
+        }
+
+    arbotixpro->SetPowerOnSettleTime(ini->geti(BOOT_SECTION, "settle_time", arbotixpro->GetPowerOnSettleTime()));
+    m_BootTimeout = ini->geti(BOOT_SECTION, "boot_timeout", m_BootTimeout);
+    m_Response.LoadINISettings(ini);
+    m_Compensate = ini->geti(RESPONSE_SECTION, "compensate", m_Compensate ? 1 : 0) != 0;
+    SetPeriod(ini->getd(TIMER_SECTION, "period", m_Period));
+    SetIdlePeriod(ini->getd(TIMER_SECTION, "idle_period", m_IdlePeriod));
+    SetBlendTime(ini->geti(TIMER_SECTION, "blend_time", m_BlendTime));
+    SetFadeIn(ini->geti(BOOT_SECTION, "fade_in_torque", 0), ini->geti(BOOT_SECTION, "fade_in_time", DEST_TORQUE * MotionModule::TIME_UNIT / 2));
+
+    if (Initialize(arbotixpro, fadeIn) == false)
+        return false;
+
+    // the joints found differ from the map, the next boot checks these
+    bool changed = false;
+    map = "";
+    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+        {
+            if (m_ServoMap[id] != MotionStatus::m_CurrentJoints.GetEnable(id))
+                changed = true;
+            if (MotionStatus::m_CurrentJoints.GetEnable(id) == true)
+                {
+                    sprintf(buffer, "%s%d", map.empty() ? "" : ",", id);
+                    map += buffer;
+                }
+        }
+    if (changed == true)
+        ini->put(BOOT_SECTION, "servo_map", map);
+
+    return true;
+}
+
 bool MotionManager::Reinitialize()
 {
     m_ProcessEnable = false;
 
-    m_ArbotixPro->DXLPowerOn();
+    for (int port = 0; port < m_NumPorts; port++)
+        {
+            GetPort(port)->DXLPowerCycle();
+            GetPort(port)->ResetHealth();
+        }
 
-    int value, error;
-    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+    DiscoverJoints();
+    UpdateHealth();
+
+    m_ProcessEnable = true;
+    return true;
+}
+
+// One bulk read of the present position of the given joints not yet
+// present; true when every one of them answered. A Protocol 1.0 bulk read
+// is chained and stops at the first servo that does not answer, so the
+// joints it left out are asked one at a time.
+bool MotionManager::ProbeJoints(int number, int *id, bool *present)
+{
+    bool all = true;
+
+    for (int port = 0; port < m_NumPorts; port++)
         {
-            if (DEBUG_PRINT == true)
-                fprintf(stderr, "ID:%d initializing...", id);
+            ArbotixPro *arbotixpro = GetPort(port);
+            double since = arbotixpro->GetCurrentTime();
+            int port_id[JointData::NUMBER_OF_JOINTS];
+            int port_num = 0;
 
-            if (m_ArbotixPro->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &value, &error) == ArbotixPro::SUCCESS)
+            for (int i = 0; i < number; i++)
                 {
-                    MotionStatus::m_CurrentJoints.SetValue(id, value);
-                    MotionStatus::m_CurrentJoints.SetEnable(id, true);
+                    if (m_JointPort[id[i]] == port && present[id[i]] == false)
+                        port_id[port_num++] = id[i];
+                }
+            if (port_num == 0)
+                continue;
 
-                    if (DEBUG_PRINT == true)
-                        fprintf(stderr, "[%d] Success\n", value);
+            arbotixpro->RefreshShadow(port_num, port_id, AXDXL::P_PRESENT_POSITION_L, AXDXL::P_PRESENT_POSITION_H, 0.0);
+
+            for (int i = 0; i < port_num; i++)
+                {
+                    unsigned char data[2];
+                    int value;
+                    if (arbotixpro->GetShadow()->Read(port_id[i], AXDXL::P_PRESENT_POSITION_L, data, 2, since) == true)
+                        value = ArbotixPro::MakeWord(data[0], data[1]);
+                    else if (arbotixpro->ReadWord(port_id[i], AXDXL::P_PRESENT_POSITION_L, &value, 0) != ArbotixPro::SUCCESS)
+                        {
+                            all = false;
+                            continue;
+                        }
+                    present[port_id[i]] = true;
+                    MotionStatus::m_CurrentJoints.SetValue(port_id[i], value);
                 }
-            else
+        }
+
+    return all;
+}
+
+int MotionManager::AddPort(ArbotixPro *arbotixpro)
+{
+    if (m_NumPorts >= MAX_PORTS)
+        return -1;
+
+    m_Worker[m_NumPorts] = new BusWorker(arbotixpro);
+    return m_NumPorts++;
+}
+
+void MotionManager::SetJointPort(int id, int port)
+{
+    if (id < JointData::ID_MIN || id > JointData::ID_MAX || port < 0 || port >= m_NumPorts)
+        return;
+
+    m_JointPort[id] = port;
+    if (m_ArbotixPro != 0)
+        AttachJoints();
+}
+
+void MotionManager::AttachJoints()
+{
+    for (int port = 0; port < m_NumPorts; port++)
+        {
+            for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+                GetPort(port)->SetJointAttached(id, m_JointPort[id] == port);
+        }
+}
+
+// The job on every port at once; returns when all of them are done.
+void MotionManager::RunPorts(int job)
+{
+    for (int port = 1; port < m_NumPorts; port++)
+        m_Worker[port]->Post(job);
+
+    BusWorker::Run(m_ArbotixPro, job);
+
+    for (int port = 1; port < m_NumPorts; port++)
+        m_Worker[port]->Wait();
+}
+
+void MotionManager::WriteWordAllPorts(int address, int value)
+{
+    for (int port = 0; port < m_NumPorts; port++)
+        GetPort(port)->WriteWord(ArbotixPro::ID_BROADCAST, address, value, 0, 0);
+}
+
+// Enables the joints that answer. The joints of the servo map are checked
+// first, again until boot timeout for servos that are still booting; the
+// other IDs take one more bulk read, so a servo added since is still found.
+// Returns true when every joint of the map answered.
+bool MotionManager::DiscoverJoints()
+{
+    int id[JointData::NUMBER_OF_JOINTS];
+    bool present[JointData::NUMBER_OF_JOINTS];
+    int num = 0;
+    bool match = false;
+
+    for (int i = 0; i < JointData::NUMBER_OF_JOINTS; i++)
+        present[i] = false;
+
+    for (int i = JointData::ID_MIN; i <= JointData::ID_MAX; i++)
+        {
+            if (m_ServoMap[i] == true)
+                id[num++] = i;
+        }
+
+    if (num > 0)
+        {
+            double deadline = m_ArbotixPro->GetCurrentTime() + m_BootTimeout;
+            while ((match = ProbeJoints(num, id, present)) == false && m_ArbotixPro->GetCurrentTime() < deadline)
+                usleep(1000);
+
+            if (match == false && DEBUG_PRINT == true)
+                fprintf(stderr, "Servo map does not match\n");
+        }
+
+    num = 0;
+    for (int i = JointData::ID_MIN; i <= JointData::ID_MAX; i++)
+        {
+            if (m_ServoMap[i] == false)
+                id[num++] = i;
+        }
+    if (num > 0)
+        ProbeJoints(num, id, present);
+
+    for (int i = JointData::ID_MIN; i <= JointData::ID_MAX; i++)
+        {
+            // Protocol 2.0 packets keep the AX/MX addresses
+            int model;
+            ArbotixPro *arbotixpro = GetPort(m_JointPort[i]);
+            if (present[i] == true && arbotixpro->GetProtocol() == ArbotixPro::PROTOCOL_2
+                    && arbotixpro->ReadWord(i, AXDXL::P_MODEL_NUMBER_L, &model, 0) == ArbotixPro::SUCCESS && AXDXL::IsModel(model) == false)
                 {
-                    MotionStatus::m_CurrentJoints.SetEnable(id, false);
+                    fprintf(stderr, " ID:%d model %d has no AX/MX control table, not driven over Protocol 2.0\n", i, model);
+                    present[i] = false;
+                }
 
-                    if (DEBUG_PRINT == true)
-                        fprintf(stderr, " Fail\n");
+            MotionStatus::m_CurrentJoints.SetEnable(i, present[i]);
+
+            if (DEBUG_PRINT == true)
+                {
+                    if (present[i] == true)
+                        fprintf(stderr, "ID:%d [%d] Success\n", i, MotionStatus::m_CurrentJoints.GetValue(i));
+                    else
+                        fprintf(stderr, "ID:%d Fail\n", i);
                 }
         }
 
-    m_ProcessEnable = true;
-    return true;
+    return match;
+}
+
+void MotionManager::SetFadeIn(int torque, int msec)
+{
+    m_FadeInStart = (torque < 0) ? 0 : (torque > DEST_TORQUE) ? DEST_TORQUE : torque;
+    m_FadeInTime = msec;
+    m_FadeInStep = (msec <= m_Period) ? DEST_TORQUE : (int)((DEST_TORQUE - m_FadeInStart) * m_Period / msec);
+    if (m_FadeInStep < 1)
+        m_FadeInStep = 1;
+}
+
+void MotionManager::SetPeriod(double msec)
+{
+    if (msec <= 0)
+        return;
+
+    m_Period = msec;
+    MotionModule::PERIOD = msec;
+    m_IdleTime = 0;
+    if (m_ArbotixPro != 0)
+        {
+            for (int port = 0; port < m_NumPorts; port++)
+                GetPort(port)->SetRefreshTime(BUS_SHARE * msec);
+        }
+    SetFadeIn(m_FadeInStart, m_FadeInTime);
+    m_TickStatistics.SetPeriod(msec);
 }
 
 void MotionManager::StartLogging()
 {
     char szFile[32] = {0,};
 
+    if (m_IsLogging == true)
+        return;
+
     int count = 0;
     while (1)
         {
@@ -148,18 +476,52 @@ void MotionManager::StartLogging()
             count++;
             if (count > 256) return;
         }
-    m_LogFileStream.open(szFile, std::ios::out);
-    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
-        m_LogFileStream << "nID_" << id << "_GP,nID_" << id << "_PP,";
-    m_LogFileStream << "GyroFB,GyroRL,AccelFB,AccelRL,L_FSR_X,L_FSR_Y,R_FSR_X,R_FSR_Y," << "\x0d\x0a";
 
+    if (m_LogRecord == 0)
+        m_LogRecord = new LogRecord[MAXNUM_LOG_RECORD];
+    strcpy(m_LogFile, szFile);
+    m_LogCount = 0;
+    m_LogDropped = 0;
+    __sync_synchronize();
     m_IsLogging = true;
 }
 
 void MotionManager::StopLogging()
 {
+    if (m_IsLogging == false)
+        return;
+
+    // a tick that has seen the flag is let finish its record
     m_IsLogging = false;
-    m_LogFileStream.close();
+    __sync_synchronize();
+    while (m_IsRunning == true)
+        usleep(1000);
+
+    FILE *log = fopen(m_LogFile, "w");
+    if (log == 0)
+        {
+            if (DEBUG_PRINT == true)
+                fprintf(stderr, "Can not open %s\n", m_LogFile);
+            return;
+        }
+
+    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+        fprintf(log, "nID_%d_GP,nID_%d_PP,", id, id);
+    fprintf(log, "GyroFB,GyroRL,AccelFB,AccelRL,L_FSR_X,L_FSR_Y,R_FSR_X,R_FSR_Y,\x0d\x0a");
+
+    for (int i = 0; i < m_LogCount; i++)
+        {
+            LogRecord *record = &m_LogRecord[i];
+            for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+                fprintf(log, "%d,%d,", record->goal[id], record->present[id]);
+            for (int n = 0; n < 8; n++)
+                fprintf(log, "%d,", record->sensor[n]);
+            fprintf(log, "\x0d\x0a");
+        }
+    fclose(log);
+
+    if (m_LogDropped > 0 && DEBUG_PRINT == true)
+        fprintf(stderr, "%s: %u ticks not logged\n", m_LogFile, m_LogDropped);
 }
 
 void MotionManager::LoadINISettings(minIni* ini)
@@ -198,16 +560,37 @@ void MotionManager::SaveINISettings(minIni* ini, const std::string &section)
 #define MARGIN_OF_SD        2.0
 void MotionManager::Process()
 {
+    double start = m_ArbotixPro->GetCurrentTime();
+    double sync_write = 0.0, bulk_read = 0.0;
+
     if (m_fadeIn && m_torque_count < DEST_TORQUE)
         {
-            m_ArbotixPro->WriteWord(ArbotixPro::ID_BROADCAST, AXDXL::P_TORQUE_LIMIT_L, m_torque_count, 0);
-            m_torque_count += 2;
+            m_torque_count += m_FadeInStep;
+            if (m_torque_count > DEST_TORQUE)
+                m_torque_count = DEST_TORQUE;
+            WriteWordAllPorts(AXDXL::P_TORQUE_LIMIT_L, m_torque_count);
+            sync_write = m_ArbotixPro->GetCurrentTime() - start;
         }
 
-    if (m_ProcessEnable == false || m_IsRunning == true)
+    // RemoveModule() holds the flag while it changes the modules
+    if (m_ProcessEnable == false || __sync_bool_compare_and_swap(&m_IsRunning, false, true) == false)
         return;
 
-    m_IsRunning = true;
+    // seen by StopLogging() before m_IsLogging is read below
+    __sync_synchronize();
+    m_Moved = false;
+    int job = 0;
+
+    // the response to the last tick's request has been arriving meanwhile,
+    // the bus is then idle until the goal positions are sent
+    if (m_Pipelined == true)
+        {
+            RunPorts(BusWorker::JOB_COLLECT);
+            bulk_read = m_ArbotixPro->GetCurrentTime() - start;
+            UpdateFeedback();
+            UpdateHealth();
+        }
+
     // calibrate gyro sensor
     if (m_CalibrationStatus == 0 || m_CalibrationStatus == -1)
         {
@@ -275,7 +658,8 @@ void MotionManager::Process()
             static int buf_idx = 0;
             if (m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].error == 0)
                 {
-                    const double GYRO_ALPHA = 0.1;
+                    // 0.1 of the way per TIME_UNIT
+                    const double GYRO_ALPHA = 1.0 - pow(0.9, MotionModule::PERIOD / MotionModule::TIME_UNIT);
                     int gyroValFB = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_GYRO_Y_L) - m_FBGyroCenter;
                     int gyroValRL = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_GYRO_X_L) - m_RLGyroCenter;
 
@@ -288,7 +672,7 @@ void MotionManager::Process()
 
                     if (++buf_idx >= ACCEL_WINDOW_SIZE) buf_idx = 0;
 
-                    const double TICKS_TO_RADIANS_PER_STEP = (M_PI / 180.0) * 250.0 / 512.0 * (0.001 * MotionModule::TIME_UNIT);
+                    const double TICKS_TO_RADIANS_PER_STEP = (M_PI / 180.0) * 250.0 / 512.0 * (0.001 * MotionModule::PERIOD);
                     m_angleEstimator.predict(
                         -TICKS_TO_RADIANS_PER_STEP * gyroValFB,
                         TICKS_TO_RADIANS_PER_STEP * gyroValRL,
@@ -321,141 +705,480 @@ void MotionManager::Process()
             else
                 MotionStatus::FALLEN = STANDUP;
 
-            if (m_Modules.size() != 0)
+            bool changed = m_OwnersChanged;
+            for (int i = 0; i < m_NumModules; i++)
                 {
-                    for (std::list<MotionModule*>::iterator i = m_Modules.begin(); i != m_Modules.end(); i++)
-                        {
-                            (*i)->Process();
-                            for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
-                                {
-                                    if ((*i)->m_Joint.GetEnable(id) == true)
-                                        {
-                                            MotionStatus::m_CurrentJoints.SetSlope(id, (*i)->m_Joint.GetCWSlope(id), (*i)->m_Joint.GetCCWSlope(id));
-                                            MotionStatus::m_CurrentJoints.SetValue(id, (*i)->m_Joint.GetValue(id));
-
-                                            // MotionStatus::m_CurrentJoints.SetPGain(id, (*i)->m_Joint.GetPGain(id));
-                                            // MotionStatus::m_CurrentJoints.SetIGain(id, (*i)->m_Joint.GetIGain(id));
-                                            // MotionStatus::m_CurrentJoints.SetDGain(id, (*i)->m_Joint.GetDGain(id));
-                                        }
-                                }
-                        }
+                    m_Modules[i]->Process();
+                    if (m_Modules[i]->m_Joint.GetEnableMask() != m_ModuleMask[i])
+                        changed = true;
                 }
+            if (changed == true)
+                AssignOwners();
+            Compose();
+
+            // writes queued by other threads go out with the goal positions
+            QueueJointSyncWrite();
+            for (int port = 0; port < m_NumPorts; port++)
+                GetPort(port)->QueueDelayedWrites();
+            job = BusWorker::JOB_FLUSH;
+        }
 
-            int param[JointData::NUMBER_OF_JOINTS * AXDXL::PARAM_BYTES];
-            int n = 0;
-            int joint_num = 0;
-            for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+    double bus = m_ArbotixPro->GetCurrentTime();
+    if (m_Pipelined == true)
+        {
+            // goal positions and the bulk read request in one write, the
+            // response is collected at the start of the next tick
+            RunPorts(BusWorker::JOB_FLUSH_BULK_READ);
+            sync_write += m_ArbotixPro->GetCurrentTime() - bus;
+        }
+    else
+        {
+            RunPorts(job | BusWorker::JOB_BULK_READ);
+            // the bulk read of the main port starts where the goals are out
+            double request = m_ArbotixPro->GetSensorTime();
+            if (request >= bus)
                 {
-                    if (MotionStatus::m_CurrentJoints.GetEnable(id) == true)
-                        {
-                            param[n++] = id;
-
-                            param[n++] = MotionStatus::m_CurrentJoints.GetCWSlope(id);
-                            param[n++] = MotionStatus::m_CurrentJoints.GetCCWSlope(id);
+                    sync_write += request - bus;
+                    bulk_read = m_ArbotixPro->GetCurrentTime() - request;
+                }
+            else
+                bulk_read = m_ArbotixPro->GetCurrentTime() - bus;
+            UpdateFeedback();
+            UpdateHealth();
+        }
 
-                            param[n++] = ArbotixPro::GetLowByte(MotionStatus::m_CurrentJoints.GetValue(id) + m_Offset[id]);
-                            param[n++] = ArbotixPro::GetHighByte(MotionStatus::m_CurrentJoints.GetValue(id) + m_Offset[id]);
-                            joint_num++;
+    if (m_IsLogging == true)
+        {
+            if (m_LogCount < MAXNUM_LOG_RECORD)
+                {
+                    LogRecord *record = &m_LogRecord[m_LogCount];
+                    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+                        {
+                            record->goal[id] = MotionStatus::m_CurrentJoints.GetValue(id);
+                            record->present[id] = MotionStatus::m_CurrentJoints.GetPresentPosition(id);
                         }
 
-                    if (DEBUG_PRINT == true)
-                        fprintf(stderr, "ID[%d] : %d \n", id, MotionStatus::m_CurrentJoints.GetValue(id));
+                    record->sensor[0] = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_GYRO_Y_L);
+                    record->sensor[1] = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_GYRO_X_L);
+                    record->sensor[2] = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_ACCEL_Y_L);
+                    record->sensor[3] = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_ACCEL_X_L);
+                    record->sensor[4] = m_ArbotixPro->m_BulkReadData[FSR::ID_L_FSR].ReadByte(FSR::P_FSR_X);
+                    record->sensor[5] = m_ArbotixPro->m_BulkReadData[FSR::ID_L_FSR].ReadByte(FSR::P_FSR_Y);
+                    record->sensor[6] = m_ArbotixPro->m_BulkReadData[FSR::ID_R_FSR].ReadByte(FSR::P_FSR_X);
+                    record->sensor[7] = m_ArbotixPro->m_BulkReadData[FSR::ID_R_FSR].ReadByte(FSR::P_FSR_Y);
+                    m_LogCount++;
                 }
+            else
+                m_LogDropped++;
+        }
 
-            if (joint_num > 0)
-                m_ArbotixPro->SyncWrite(AXDXL::P_CW_COMPLIANCE_SLOPE, AXDXL::PARAM_BYTES, joint_num, param);
+    m_IsRunning = false;
 
-            unsigned int ic = 0;
-            while (ic < m_ArbotixPro->m_DelayedWords)
-                {
-                    m_ArbotixPro->WriteWord(m_ArbotixPro->m_DelayedAddress[ic], m_ArbotixPro->m_DelayedWord[ic], 0);
-                    ic++;
-                }
-            m_ArbotixPro->m_DelayedWords = 0;
+    // not while the torque limit is fading in
+    if ((m_fadeIn == false || m_torque_count >= DEST_TORQUE) && --m_torqueAdaptionCounter == 0)
+        {
+            m_torqueAdaptionCounter = Cycles(TORQUE_ADAPTION_TIME);
+            adaptTorqueToVoltage();
+        }
+
+    // the other threads see this tick as a whole from here on
+    MotionStatus::Publish();
+
+    // the period the timer sleeps now is the step of the next tick
+    if (m_Moved == true || (m_fadeIn == true && m_torque_count < DEST_TORQUE))
+        m_IdleTime = 0;
+    else
+        m_IdleTime += MotionModule::PERIOD;
+    MotionModule::PERIOD = (m_IdlePeriod > m_Period && m_IdleTime >= IDLE_TIME) ? m_IdlePeriod : m_Period;
+
+    double total = m_ArbotixPro->GetCurrentTime() - start;
+    m_TickStatistics.Record(TickStatistics::SYNC_WRITE, sync_write);
+    m_TickStatistics.Record(TickStatistics::BULK_READ, bulk_read);
+    m_TickStatistics.Record(TickStatistics::COMPUTE, total - sync_write - bulk_read);
+    m_TickStatistics.Record(TickStatistics::TOTAL, total);
+}
+
+void MotionManager::QueueJointSyncWrite()
+{
+    bool refresh = false;
+
+    // every joint is sent now and then in case a servo lost its goal
+    if (--m_RefreshCounter <= 0)
+        {
+            m_RefreshCounter = Cycles(FULL_REFRESH_TIME);
+            refresh = true;
         }
-    m_ArbotixPro->BulkRead();
-    // update joint temps
+
+    for (int port = 0; port < m_NumPorts; port++)
+        QueueJointSyncWrite(port, refresh);
+}
+
+void MotionManager::QueueJointSyncWrite(int port, bool refresh)
+{
+    int full[JointData::NUMBER_OF_JOINTS * AXDXL::PARAM_BYTES];
+    int slope[JointData::NUMBER_OF_JOINTS * 3];
+    int position[JointData::NUMBER_OF_JOINTS * 3];
+    int sent[JointData::NUMBER_OF_JOINTS];
+    int sent_value[JointData::NUMBER_OF_JOINTS];
+    int full_num = 0, slope_num = 0, position_num = 0, sent_num = 0;
+    int n = 0, s = 0, p = 0;
+
     for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
         {
+            if (m_JointPort[id] != port)
+                continue;
+
             if (MotionStatus::m_CurrentJoints.GetEnable(id) == true)
                 {
-                    int value = m_ArbotixPro->m_BulkReadData[id].ReadByte(AXDXL::P_PRESENT_TEMPERATURE);
-                    MotionStatus::m_CurrentJoints.SetTemp(id, value);
+                    int value = MotionStatus::m_CurrentJoints.GetValue(id);
+                    if (m_Compensate == true)
+                        value = m_Response.Lead(id, value);
+                    value += m_Offset[id];
+                    int changed = MotionStatus::m_CurrentJoints.GetChanged(id);
+                    // the lead also changes while the goal does not
+                    if (m_Offset[id] != m_SentOffset[id] || value != m_SentValue[id])
+                        changed |= JointData::CHANGED_VALUE;
+                    if (value != m_SentValue[id])
+                        m_Moved = true;
+
+                    if (refresh == true)
+                        {
+                            full[n++] = id;
+                            full[n++] = MotionStatus::m_CurrentJoints.GetCWSlope(id);
+                            full[n++] = MotionStatus::m_CurrentJoints.GetCCWSlope(id);
+                            full[n++] = ArbotixPro::GetLowByte(value);
+                            full[n++] = ArbotixPro::GetHighByte(value);
+                            full_num++;
+                        }
+                    else
+                        {
+                            if (changed & JointData::CHANGED_SLOPE)
+                                {
+                                    slope[s++] = id;
+                                    slope[s++] = MotionStatus::m_CurrentJoints.GetCWSlope(id);
+                                    slope[s++] = MotionStatus::m_CurrentJoints.GetCCWSlope(id);
+                                    slope_num++;
+                                }
+                            if (changed & JointData::CHANGED_VALUE)
+                                {
+                                    position[p++] = id;
+                                    position[p++] = ArbotixPro::GetLowByte(value);
+                                    position[p++] = ArbotixPro::GetHighByte(value);
+                                    position_num++;
+                                }
+                        }
+
+                    sent[sent_num] = id;
+                    sent_value[sent_num++] = value;
                 }
+            else
+                m_Response.Reset(id);
+
+            if (DEBUG_PRINT == true)
+                fprintf(stderr, "ID[%d] : %d \n", id, MotionStatus::m_CurrentJoints.GetValue(id));
         }
-    if (m_IsLogging)
+
+    ArbotixPro *arbotixpro = GetPort(port);
+    if (arbotixpro->QueueSyncWrite(AXDXL::P_CW_COMPLIANCE_SLOPE, AXDXL::PARAM_BYTES, full_num, full) != ArbotixPro::SUCCESS
+            || arbotixpro->QueueSyncWrite(AXDXL::P_CW_COMPLIANCE_SLOPE, 3, slope_num, slope) != ArbotixPro::SUCCESS
+            || arbotixpro->QueueSyncWrite(AXDXL::P_GOAL_POSITION_L, 3, position_num, position) != ArbotixPro::SUCCESS)
         {
-            for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
-                m_LogFileStream << MotionStatus::m_CurrentJoints.GetValue(id) << "," << m_ArbotixPro->m_BulkReadData[id].ReadWord(AXDXL::P_PRESENT_POSITION_L) << ",";
+            // not sent, every joint goes out with the next tick
+            m_RefreshCounter = 1;
+            return;
+        }
 
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_GYRO_Y_L) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_GYRO_X_L) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_ACCEL_Y_L) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadWord(ArbotixPro::P_ACCEL_X_L) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[FSR::ID_L_FSR].ReadByte(FSR::P_FSR_X) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[FSR::ID_L_FSR].ReadByte(FSR::P_FSR_Y) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[FSR::ID_R_FSR].ReadByte(FSR::P_FSR_X) << ",";
-            m_LogFileStream << m_ArbotixPro->m_BulkReadData[FSR::ID_R_FSR].ReadByte(FSR::P_FSR_Y) << ",";
-            m_LogFileStream << "\x0d\x0a";
+    for (int i = 0; i < sent_num; i++)
+        {
+            int id = sent[i];
+            MotionStatus::m_CurrentJoints.ClearChanged(id);
+            m_SentOffset[id] = m_Offset[id];
+            m_SentValue[id] = sent_value[i];
+        }
+}
+
+void MotionManager::UpdateFeedback()
+{
+    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+        {
+            if (MotionStatus::m_CurrentJoints.GetEnable(id) == true)
+                {
+                    ArbotixPro *arbotixpro = GetPort(m_JointPort[id]);
+                    BulkReadData *data = &arbotixpro->m_BulkReadData[id];
+                    bool slow = false;
+                    if (data->Contains(AXDXL::P_PRESENT_POSITION_L, 2))
+                        MotionStatus::m_CurrentJoints.SetPresentPosition(id, data->ReadWord(AXDXL::P_PRESENT_POSITION_L));
+                    if (data->Contains(AXDXL::P_PRESENT_SPEED_L, 2))
+                        MotionStatus::m_CurrentJoints.SetPresentSpeed(id, data->ReadWord(AXDXL::P_PRESENT_SPEED_L));
+                    if (data->Contains(AXDXL::P_PRESENT_LOAD_L, 2))
+                        {
+                            MotionStatus::m_CurrentJoints.SetPresentLoad(id, data->ReadWord(AXDXL::P_PRESENT_LOAD_L));
+                            slow = true;
+                        }
+                    if (data->Contains(AXDXL::P_PRESENT_VOLTAGE, 1))
+                        {
+                            MotionStatus::m_CurrentJoints.SetVoltage(id, data->ReadByte(AXDXL::P_PRESENT_VOLTAGE));
+                            slow = true;
+                        }
+                    if (data->Contains(AXDXL::P_PRESENT_TEMPERATURE, 1))
+                        {
+                            MotionStatus::m_CurrentJoints.SetTemp(id, data->ReadByte(AXDXL::P_PRESENT_TEMPERATURE));
+                            slow = true;
+                        }
+                    if (slow == true)
+                        MotionStatus::SLOW_SENSOR_TIME[id] = arbotixpro->GetSensorTime();
+                }
         }
 
     if (m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].error == 0)
         MotionStatus::BUTTON = m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM].ReadByte(ArbotixPro::P_BUTTON);
-    m_IsRunning = false;
+    MotionStatus::SENSOR_TIME = m_ArbotixPro->GetSensorTime();
+}
+
+// Follows the quarantine of the ports. A joint back from it may have lost
+// power, so it gets the torque limit again and every joint a full refresh.
+void MotionManager::UpdateHealth()
+{
+    int torque = (m_fadeIn == true && m_torque_count < DEST_TORQUE) ? m_torque_count : (int)(m_voltageAdaptionFactor * DEST_TORQUE);
 
-    if (m_torque_count != DEST_TORQUE && --m_torqueAdaptionCounter == 0)
+    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
         {
-            m_torqueAdaptionCounter = TORQUE_ADAPTION_CYCLES;
-            adaptTorqueToVoltage();
+            bool quarantined = GetPort(m_JointPort[id])->IsJointQuarantined(id);
+            if (quarantined == m_Quarantined[id])
+                continue;
+
+            if (quarantined == false)
+                {
+                    GetPort(m_JointPort[id])->WriteWordDelayed(id, AXDXL::P_TORQUE_LIMIT_L, torque);
+                    m_RefreshCounter = 1;
+                }
+            if (DEBUG_PRINT == true)
+                fprintf(stderr, "ID:%d %s\n", id, quarantined == true ? "quarantined" : "back");
+            m_Quarantined[id] = quarantined;
         }
 }
 
 void MotionManager::SetEnable(bool enable)
 {
     m_Enabled = enable;
+    m_RefreshCounter = 1;
     if (m_Enabled == true)
-        m_ArbotixPro->WriteWord(ArbotixPro::ID_BROADCAST, AXDXL::P_MOVING_SPEED_L, 0, 0);
+        WriteWordAllPorts(AXDXL::P_MOVING_SPEED_L, 0);
 }
 
-void MotionManager::AddModule(MotionModule *module)
+bool MotionManager::AddModule(MotionModule *module)
 {
-    module->Initialize();
-    m_Modules.push_back(module);
+    if (m_NumModules >= MAX_MODULES)
+        {
+            if (DEBUG_PRINT == true)
+                fprintf(stderr, "No room for another motion module\n");
+            return false;
+        }
 
+    module->Initialize();
+    m_Modules[m_NumModules] = module;
+    m_ModuleBlend[m_NumModules] = -1;
+    m_OwnersChanged = true;
+    // the motion thread sees the module only once it is in place
+    __sync_synchronize();
+    m_NumModules++;
+    return true;
 }
 
 void MotionManager::RemoveModule(MotionModule *module)
 {
-    m_Modules.remove(module);
+    int n = 0;
+
+    // not while a tick runs, and none starts before the module is out
+    while (__sync_bool_compare_and_swap(&m_IsRunning, false, true) == false)
+        usleep(1000);
+
+    for (int i = 0; i < m_NumModules; i++)
+        {
+            if (m_Modules[i] != module)
+                {
+                    m_Modules[n] = m_Modules[i];
+                    m_ModuleMask[n] = m_ModuleMask[i];
+                    m_ModuleBlend[n] = m_ModuleBlend[i];
+                    n++;
+                }
+        }
+    m_NumModules = n;
+
+    // the next tick assigns its joints again, a fade from it goes on from its last goal
+    for (int s = 0; s < m_NumSlots; s++)
+        {
+            JointSlot *slot = &m_Slot[s];
+            if (slot->owner == module)
+                {
+                    slot->owner = 0;
+                    m_Owner[slot->id] = 0;
+                }
+            if (slot->from == module)
+                {
+                    slot->hold = module->m_Joint.GetValue(slot->id);
+                    slot->from = 0;
+                }
+        }
+    m_OwnersChanged = true;
+    __sync_synchronize();
+    m_IsRunning = false;
+}
+
+bool MotionManager::IsModule(MotionModule *module)
+{
+    for (int i = 0; i < m_NumModules; i++)
+        {
+            if (m_Modules[i] == module)
+                return true;
+        }
+    return false;
 }
 
-void MotionManager::SetJointDisable(int index)
+void MotionManager::SetBlendTime(MotionModule *module, int msec)
 {
-    if (m_Modules.size() != 0)
+    for (int i = 0; i < m_NumModules; i++)
         {
-            for (std::list<MotionModule*>::iterator i = m_Modules.begin(); i != m_Modules.end(); i++)
-                (*i)->m_Joint.SetEnable(index, false);
+            if (m_Modules[i] == module)
+                m_ModuleBlend[i] = msec;
         }
 }
 
+void MotionManager::SetJointOwner(int id, MotionModule *module, int msec)
+{
+    if (m_Owner[id] == module && module->m_Joint.GetEnable(id) == true)
+        return;
+
+    m_JointBlend[id] = msec;
+    module->m_Joint.SetEnable(id, true, true);
+}
+
+// Only when an enable or the modules changed. A joint keeps its slot while
+// its owner stays. A new owner fades in from the previous one, or from the
+// goal last given when that one is gone or was fading itself.
+void MotionManager::AssignOwners()
+{
+    JointSlot slot[JointData::NUMBER_OF_JOINTS];
+    int slot_of[JointData::NUMBER_OF_JOINTS];
+    int num = 0;
+
+    for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+        slot_of[id] = -1;
+    m_OwnersChanged = false;
+    for (int i = 0; i < m_NumModules; i++)
+        m_ModuleMask[i] = m_Modules[i]->m_Joint.GetEnableMask();
+
+    for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+        {
+            MotionModule *owner = 0;
+            int blend = m_BlendTime;
+            for (int i = 0; i < m_NumModules; i++)
+                {
+                    if ((m_ModuleMask[i] & (1u << id)) != 0)
+                        {
+                            owner = m_Modules[i];
+                            blend = (m_ModuleBlend[i] >= 0) ? m_ModuleBlend[i] : m_BlendTime;
+                        }
+                }
+            if (m_JointBlend[id] >= 0)
+                blend = m_JointBlend[id];
+            m_JointBlend[id] = -1;
+
+            JointSlot *old = (m_SlotOf[id] >= 0) ? &m_Slot[m_SlotOf[id]] : 0;
+            m_Owner[id] = owner;
+            if (owner == 0)
+                continue;
+
+            JointSlot *s = &slot[num];
+            if (old != 0 && old->owner == owner)
+                {
+                    *s = *old;
+                    if (s->from != 0 && IsModule(s->from) == false)
+                        s->from = 0;
+                }
+            else
+                {
+                    s->id = id;
+                    s->owner = owner;
+                    s->hold = MotionStatus::m_CurrentJoints.GetValue(id);
+                    s->from = (old != 0 && old->length == 0 && IsModule(old->owner) == true) ? old->owner : 0;
+                    s->time = 0;
+                    s->length = (blend > 0) ? blend : 0;
+                }
+            slot_of[id] = num++;
+        }
+
+    for (int n = 0; n < num; n++)
+        m_Slot[n] = slot[n];
+    for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+        m_SlotOf[id] = slot_of[id];
+    m_NumSlots = num;
+}
+
+// the goals of the owned joints, weighted by the time into their fade
+void MotionManager::Compose()
+{
+    for (int n = 0; n < m_NumSlots; n++)
+        {
+            JointSlot *slot = &m_Slot[n];
+            JointData *joint = &slot->owner->m_Joint;
+            int id = slot->id;
+            int value = joint->GetValue(id);
+
+            if (slot->length > 0)
+                {
+                    slot->time += MotionModule::PERIOD;
+                    if (slot->time >= slot->length)
+                        {
+                            slot->length = 0;
+                            slot->from = 0;
+                        }
+                    else
+                        {
+                            int from = (slot->from != 0) ? slot->from->m_Joint.GetValue(id) : slot->hold;
+                            value = from + (int)floor((value - from) * slot->time / slot->length + 0.5);
+                        }
+                }
+
+            MotionStatus::m_CurrentJoints.SetSlope(id, joint->GetCWSlope(id), joint->GetCCWSlope(id));
+            MotionStatus::m_CurrentJoints.SetValue(id, value);
+
+            // MotionStatus::m_CurrentJoints.SetPGain(id, joint->GetPGain(id));
+            // MotionStatus::m_CurrentJoints.SetIGain(id, joint->GetIGain(id));
+            // MotionStatus::m_CurrentJoints.SetDGain(id, joint->GetDGain(id));
+        }
+}
+
+void MotionManager::SetJointDisable(int index)
+{
+    for (int i = 0; i < m_NumModules; i++)
+        m_Modules[i]->m_Joint.SetEnable(index, false);
+}
+
 void MotionManager::adaptTorqueToVoltage()
 {
     const int DEST_TORQUE = 1023;
     // 13V - at 13V darwin will make no adaptation as the standard 3 cell battery is always below this voltage, this implies Nimbro-OP runs on 4 cells
     const int FULL_TORQUE_VOLTAGE = 130;
-    int voltage;
     // torque is only reduced if it is greater then FULL_TORQUE_VOLTAGE
-    if (m_ArbotixPro->ReadByte(ArbotixPro::ID_CM, ArbotixPro::P_VOLTAGE, &voltage, 0) != ArbotixPro::SUCCESS)
+    // (the board voltage comes with every bulk read, no transaction of its own)
+    BulkReadData *cm = &m_ArbotixPro->m_BulkReadData[ArbotixPro::ID_CM];
+    if (cm->Contains(ArbotixPro::P_VOLTAGE, 1) == false)
         return;
+    int voltage = cm->ReadByte(ArbotixPro::P_VOLTAGE);
 
     //Check if voltage has dropped too low; if so kill the servos and issue a poweroff command
+    //(the bus power and the poweroff on the service thread, the power switch waits the settle time)
     if ( voltage < 108 )
         {
-            printf( "MotionManager::adaptTorqueToVoltage: Voltage dropped below safe threshold. Shutting down." );
-            m_ArbotixPro->WriteByte(ArbotixPro::ID_BROADCAST, AXDXL::P_TORQUE_ENABLE, 0, 0); //kill torque
-            m_ArbotixPro->DXLPowerOn(false); //power off bus
-            system( "poweroff" );
-            while (1);
+            for (int port = 0; port < m_NumPorts; port++)
+                GetPort(port)->WriteByte(ArbotixPro::ID_BROADCAST, AXDXL::P_TORQUE_ENABLE, 0, 0, 0); //kill torque
+            m_ProcessEnable = false;
+            if (m_ServiceReady == true)
+                sem_post(&m_Shutdown);
+            else
+                m_ArbotixPro->DXLPowerOn(false); //power off bus
+            return;
         }
     voltage = (voltage > FULL_TORQUE_VOLTAGE) ? voltage : FULL_TORQUE_VOLTAGE;
     m_voltageAdaptionFactor = ((double)FULL_TORQUE_VOLTAGE) / voltage;
@@ -467,5 +1190,5 @@ void MotionManager::adaptTorqueToVoltage()
     fprintf(m_voltageLog, "%3d       %4d\n", voltage, torque);
 #endif
 
-    m_ArbotixPro->WriteWord(ArbotixPro::ID_BROADCAST, AXDXL::P_TORQUE_LIMIT_L, torque, 0);
+    WriteWordAllPorts(AXDXL::P_TORQUE_LIMIT_L, torque);
 }
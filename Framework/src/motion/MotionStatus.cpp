@@ -17,6 +17,76 @@ int MotionStatus::RL_ACCEL(0);
 
 int MotionStatus::BUTTON(0);
 int MotionStatus::FALLEN(0);
+double MotionStatus::SENSOR_TIME(0);
+double MotionStatus::SLOW_SENSOR_TIME[JointData::NUMBER_OF_JOINTS] = { 0, };
 
 double MotionStatus::ANGLE_PITCH(0);
 double MotionStatus::ANGLE_ROLL(0);
+
+MotionSnapshot MotionStatus::m_Snapshot[2];
+volatile unsigned int MotionStatus::m_Sequence(0);
+
+
+MotionSnapshot::MotionSnapshot()
+{
+	TICK = 0;
+	FB_GYRO = 0;
+	RL_GYRO = 0;
+	FB_ACCEL = 0;
+	RL_ACCEL = 0;
+	ANGLE_PITCH = 0;
+	ANGLE_ROLL = 0;
+	BUTTON = 0;
+	FALLEN = 0;
+	SENSOR_TIME = 0;
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		SLOW_SENSOR_TIME[id] = 0;
+}
+
+void MotionStatus::Publish()
+{
+	unsigned int sequence = m_Sequence;
+	unsigned int tick = sequence / 2 + 1;
+	MotionSnapshot *snapshot = &m_Snapshot[tick & 1];
+
+	m_Sequence = sequence + 1;
+	__sync_synchronize();
+
+	snapshot->TICK = tick;
+	snapshot->m_CurrentJoints = m_CurrentJoints;
+	snapshot->FB_GYRO = FB_GYRO;
+	snapshot->RL_GYRO = RL_GYRO;
+	snapshot->FB_ACCEL = FB_ACCEL;
+	snapshot->RL_ACCEL = RL_ACCEL;
+	snapshot->ANGLE_PITCH = ANGLE_PITCH;
+	snapshot->ANGLE_ROLL = ANGLE_ROLL;
+	snapshot->BUTTON = BUTTON;
+	snapshot->FALLEN = FALLEN;
+	snapshot->SENSOR_TIME = SENSOR_TIME;
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		snapshot->SLOW_SENSOR_TIME[id] = SLOW_SENSOR_TIME[id];
+
+	__sync_synchronize();
+	m_Sequence = sequence + 2;
+}
+
+MotionSnapshot MotionStatus::Snapshot()
+{
+	MotionSnapshot snapshot;
+
+	while (1)
+		{
+			unsigned int sequence = m_Sequence;
+			__sync_synchronize();
+
+			snapshot = m_Snapshot[(sequence / 2) & 1];
+
+			// the buffer read is written again once the sequence has moved
+			// past the next publication
+			__sync_synchronize();
+			if (m_Sequence - (sequence & ~1u) <= 2)
+				break;
+		}
+
+	return snapshot;
+}
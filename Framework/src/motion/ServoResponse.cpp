@@ -0,0 +1,111 @@
+/*
+ *   ServoResponse.cpp
+ *
+ *   Per-joint delay and time constant from the SyncWrite of a goal to the motion
+ *
+ */
+#include <stdio.h>
+#include "AXDXL.h"
+#include "MotionModule.h"
+#include "minIni.h"
+#include "ServoResponse.h"
+
+using namespace Robot;
+
+
+ServoResponse::ServoResponse()
+{
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		{
+			m_Delay[id] = 0.0;
+			m_Tau[id] = 0.0;
+			m_LastGoal[id] = 0;
+			m_HasLast[id] = false;
+		}
+}
+
+// time at which the response first reaches the fraction of the step,
+// interpolated between samples; negative when it never does
+static double Crossing(int number, double *time, int *position, int start, int goal, double fraction)
+{
+	double prev_time = 0.0;
+	double prev = 0.0;
+
+	for (int i = 0; i < number; i++)
+		{
+			double done = (double)(position[i] - start) / (goal - start);
+			if (done >= fraction)
+				{
+					if (i == 0 || done == prev)
+						return time[i];
+					return prev_time + (time[i] - prev_time) * (fraction - prev) / (done - prev);
+				}
+			prev_time = time[i];
+			prev = done;
+		}
+
+	return -1.0;
+}
+
+bool ServoResponse::Fit(int id, int number, double *time, int *position, int start, int goal)
+{
+	if (id < JointData::ID_MIN || id > JointData::ID_MAX || goal == start)
+		return false;
+
+	// two point fit of the dead time and the first order lag (28.3% and 63.2%)
+	double t28 = Crossing(number, time, position, start, goal, 0.283);
+	double t63 = Crossing(number, time, position, start, goal, 0.632);
+	if (t28 < 0.0 || t63 < 0.0)
+		return false;
+
+	double tau = 1.5 * (t63 - t28);
+	double delay = t63 - tau;
+	m_Delay[id] = (delay > 0.0) ? delay : 0.0;
+	m_Tau[id] = (tau > 0.0) ? tau : 0.0;
+
+	return true;
+}
+
+int ServoResponse::Lead(int id, int goal)
+{
+	int rate = (m_HasLast[id] == true) ? goal - m_LastGoal[id] : 0;	// per tick
+	m_LastGoal[id] = goal;
+	m_HasLast[id] = true;
+
+	int value = goal + (int)(rate * (m_Delay[id] + m_Tau[id]) / MotionModule::PERIOD);
+	if (value < AXDXL::MIN_VALUE)
+		value = AXDXL::MIN_VALUE;
+	else if (value > AXDXL::MAX_VALUE)
+		value = AXDXL::MAX_VALUE;
+
+	return value;
+}
+
+void ServoResponse::LoadINISettings(minIni *ini, const std::string &section)
+{
+	char key[16];
+	double value;
+
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			sprintf(key, "delay_%.2d", id);
+			if ((value = ini->getd(section, key, -1.0)) >= 0.0)
+				m_Delay[id] = value;
+			sprintf(key, "tau_%.2d", id);
+			if ((value = ini->getd(section, key, -1.0)) >= 0.0)
+				m_Tau[id] = value;
+		}
+}
+
+void ServoResponse::SaveINISettings(minIni *ini, const std::string &section)
+{
+	char key[16];
+
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			sprintf(key, "delay_%.2d", id);
+			ini->put(section, key, m_Delay[id]);
+			sprintf(key, "tau_%.2d", id);
+			ini->put(section, key, m_Tau[id]);
+		}
+}
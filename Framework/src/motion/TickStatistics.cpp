@@ -0,0 +1,86 @@
+/*
+ *   TickStatistics.cpp
+ *
+ *   Per-phase timing of the motion tick
+ *
+ */
+#include "MotionModule.h"
+#include "TickStatistics.h"
+
+using namespace Robot;
+
+
+TickStatistics::TickStatistics()
+{
+	SetPeriod(MotionModule::TIME_UNIT);
+}
+
+void TickStatistics::Record(int phase, double msec)
+{
+	m_Phase[phase].Add(msec);
+	m_Last[phase] = msec;
+}
+
+void TickStatistics::RecordOverrun(int skipped)
+{
+	m_Overruns++;
+	m_Skipped += skipped;
+}
+
+void TickStatistics::Reset()
+{
+	for (int i = 0; i < NUM_PHASE; i++)
+		{
+			m_Phase[i].Reset();
+			m_Last[i] = 0.0;
+		}
+	m_Overruns = 0;
+	m_Skipped = 0;
+}
+
+void TickStatistics::SetPeriod(double msec)
+{
+	m_Period = msec;
+
+	// two periods across the buckets, the wake-up latency a quarter of one
+	for (int i = 0; i < NUM_PHASE; i++)
+		m_Phase[i].SetBucketWidth(msec * 2.0 / Histogram::NUM_BUCKETS);
+	m_Phase[WAKEUP].SetBucketWidth(msec / 4.0 / Histogram::NUM_BUCKETS);
+
+	Reset();
+}
+
+const char* TickStatistics::GetPhaseName(int phase)
+{
+	switch (phase)
+		{
+		case WAKEUP:
+			return "WAKEUP";
+		case COMPUTE:
+			return "COMPUTE";
+		case SYNC_WRITE:
+			return "SYNC_WRITE";
+		case BULK_READ:
+			return "BULK_READ";
+		default:
+			return "TOTAL";
+		}
+}
+
+void TickStatistics::Print(FILE *fp)
+{
+	fprintf(fp, "\n %-11s %8s %8s %8s %8s %8s %8s\n",
+	        "PHASE", "COUNT", "AVG(ms)", "P50(ms)", "P99(ms)", "P999(ms)", "MAX(ms)");
+	for (int i = 0; i < NUM_PHASE; i++)
+		{
+			Histogram *phase = &m_Phase[i];
+			if (phase->GetCount() == 0)
+				continue;
+			fprintf(fp, " %-11s %8u %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+			        GetPhaseName(i), phase->GetCount(), phase->GetMean(),
+			        phase->GetPercentile(0.5), phase->GetPercentile(0.99), phase->GetPercentile(0.999), phase->GetMax());
+		}
+
+	fprintf(fp, "\n %u ticks of %.1fmsec, %u overruns dropping %u periods\n\n",
+	        GetTicks(), m_Period, m_Overruns, m_Skipped);
+}
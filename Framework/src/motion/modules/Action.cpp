@@ -19,6 +19,7 @@ Action::Action()
     DEBUG_PRINT = true;
     m_ActionFile = 0;
     m_Playing = false;
+    m_UnitTime = 0;
 }
 
 Action::~Action()
@@ -117,6 +118,15 @@ bool Action::LoadFile( char* filename )
             return false;
         }
 
+    fseek( action, 0, SEEK_SET );
+    if ( fread( m_Page, sizeof(PAGE), MAXNUM_PAGE, action ) != MAXNUM_PAGE )
+        {
+            if (DEBUG_PRINT == true)
+                fprintf(stderr, "Can not read Action file!\n");
+            fclose( action );
+            return false;
+        }
+
     if (m_ActionFile != 0)
         fclose( m_ActionFile );
 
@@ -137,7 +147,10 @@ bool Action::CreateFile(char* filename)
     PAGE page;
     ResetPage(&page);
     for (int i = 0; i < MAXNUM_PAGE; i++)
-        fwrite(&page, 1, sizeof(PAGE), action);
+        {
+            fwrite(&page, 1, sizeof(PAGE), action);
+            m_Page[i] = page;
+        }
 
     if (m_ActionFile != 0)
         fclose( m_ActionFile );
@@ -201,6 +214,7 @@ bool Action::Start(int index, PAGE *pPage)
     m_SeqCount = 0;
     m_StartingPageSeqCount = m_PlayPage.header.seq_repeats;
     m_FirstDrivingStart = true;
+    m_UnitTime = 0;
     m_Playing = true;
     return true;
 }
@@ -231,15 +245,14 @@ bool Action::IsRunning(int *iPage, int *iStep)
     return IsRunning();
 }
 
+// from the copy taken by LoadFile(), Process() plays the next page on
+// without touching the file
 bool Action::LoadPage(int index, PAGE *pPage)
 {
-    long position = (long)(sizeof(PAGE) * index);
-
-    if ( fseek( m_ActionFile, position, SEEK_SET ) != 0 )
+    if ( m_ActionFile == 0 || index < 0 || index >= MAXNUM_PAGE )
         return false;
 
-    if ( fread( pPage, 1, sizeof(PAGE), m_ActionFile ) != sizeof(PAGE) )
-        return false;
+    *pPage = m_Page[index];
 
     if ( VerifyChecksum( pPage ) == false )
         ResetPage( pPage );
@@ -260,10 +273,23 @@ bool Action::SavePage(int index, PAGE *pPage)
     if ( fwrite( pPage, 1, sizeof(PAGE), m_ActionFile ) != sizeof(PAGE) )
         return false;
 
+    m_Page[index] = *pPage;
+
     return true;
 }
 
+// The page timing counts steps of TIME_UNIT, as many are taken as the
+// period of the tick holds
 void Action::Process()
+{
+    if (m_Playing == false)
+        return;
+
+    for (m_UnitTime += PERIOD; m_UnitTime >= TIME_UNIT && m_Playing == true; m_UnitTime -= TIME_UNIT)
+        Step();
+}
+
+void Action::Step()
 {
     ////////////////////  
     unsigned char bID;
@@ -18,6 +18,14 @@ using namespace Robot;
 
 #define LOG_BALANCE 0
 
+#if LOG_BALANCE
+// samples are kept by the motion thread and written to balance.log by Stop()
+#define BALANCE_LOG_SIZE 8192
+static double balance_sample[BALANCE_LOG_SIZE][4];
+static volatile int balance_count = 0;
+static int balance_written = 0;
+#endif
+
 #define PI (3.14159265)
 
 Walking* Walking::m_UniqueInstance = new Walking();
@@ -83,8 +91,7 @@ Walking::Walking()
 
 
 #if LOG_BALANCE
-    m_balanceLog = fopen("balance.log", "w");
-    assert(m_balanceLog);
+    m_balanceLog = 0;
 #endif
 
     /* No PID on AX
@@ -378,6 +385,20 @@ void Walking::Start()
 void Walking::Stop()
 {
     m_Ctrl_Running = false;
+
+#if LOG_BALANCE
+    if (m_balanceLog == 0)
+        m_balanceLog = fopen("balance.log", "w");
+    if (m_balanceLog != 0)
+        {
+            int count = balance_count;
+            __sync_synchronize();
+            for (; balance_written < count; balance_written++)
+                fprintf(m_balanceLog, "%5.3f %5.3f %5.3f %5.3f\n", balance_sample[balance_written][0],
+                        balance_sample[balance_written][1], balance_sample[balance_written][2], balance_sample[balance_written][3]);
+            fflush(m_balanceLog);
+        }
+#endif
 }
 
 bool Walking::IsRunning()
@@ -393,7 +414,7 @@ void Walking::Process()
     double pelvis_offset_r, pelvis_offset_l;
     double angle[14], ep[12];
     double offset;
-    double TIME_UNIT = MotionModule::TIME_UNIT;
+    double TIME_UNIT = MotionModule::PERIOD;
     //                     R_HIP_YAW, R_HIP_ROLL, R_HIP_PITCH, R_KNEE, R_ANKLE_PITCH, R_ANKLE_ROLL, L_HIP_YAW, L_HIP_ROLL, L_HIP_PITCH, L_KNEE, L_ANKLE_PITCH, L_ANKLE_ROLL, R_ARM_SWING, L_ARM_SWING
     int dir[14]          = {   -1,         1,          1,        -1,         -1,           -1,          -1,         1,         -1,         1,         1,           -1,           1,           -1      };
 //  int dir[14]          = {   -1,        -1,          1,         1,         -1,            1,          -1,        -1,         -1,         -1,         1,            1,           1,           -1      };
@@ -670,7 +691,15 @@ double Walking::splineBalance(double angle, double vel, double gain)
     double offset = 1000.0 * gain * (cmd.x - angle);
 
 #if LOG_BALANCE
-    fprintf(m_balanceLog, "%5.3f %5.3f %5.3f %5.3f\n", angle, vel, offset, cmd.t);
+    if (balance_count < BALANCE_LOG_SIZE)
+        {
+            balance_sample[balance_count][0] = angle;
+            balance_sample[balance_count][1] = vel;
+            balance_sample[balance_count][2] = offset;
+            balance_sample[balance_count][3] = cmd.t;
+            __sync_synchronize();
+            balance_count++;
+        }
 #endif
 
     return offset;
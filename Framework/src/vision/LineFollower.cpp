@@ -84,8 +84,9 @@ void LineFollower::Process(BallTracker &tracker)
 	if (bHeadAuto == false)
 		{
 			double pan, tilt;
-			pan = MotionStatus::m_CurrentJoints.GetAngle(JointData::ID_HEAD_PAN);
-			tilt = MotionStatus::m_CurrentJoints.GetAngle(JointData::ID_HEAD_TILT);
+			MotionSnapshot status = MotionStatus::Snapshot();
+			pan = status.m_CurrentJoints.GetAngle(JointData::ID_HEAD_PAN);
+			tilt = status.m_CurrentJoints.GetAngle(JointData::ID_HEAD_TILT);
 			Point2D pos = Point2D(pan, tilt);
 			tracker.ball_position = pos;
 		}
@@ -140,11 +141,12 @@ void LineFollower::Process(BallTracker &tracker)
 			m_HeadScanCount = 0;
 			bTracking = true;
 			bScanning = false;
-			double pan = MotionStatus::m_CurrentJoints.GetAngle(JointData::ID_HEAD_PAN);
+			MotionSnapshot status = MotionStatus::Snapshot();
+			double pan = status.m_CurrentJoints.GetAngle(JointData::ID_HEAD_PAN);
 			double pan_range = Head::GetInstance()->GetLeftLimitAngle();
 			double pan_percent = pan / pan_range;
 
-			double tilt = MotionStatus::m_CurrentJoints.GetAngle(JointData::ID_HEAD_TILT);
+			double tilt = status.m_CurrentJoints.GetAngle(JointData::ID_HEAD_TILT);
 			double tilt_min = Head::GetInstance()->GetBottomLimitAngle();
 			double tilt_range = Head::GetInstance()->GetTopLimitAngle() - tilt_min;
 			double tilt_percent = (tilt - tilt_min) / tilt_range;
@@ -9,7 +9,8 @@
 #include <string.h>
 #include <fcntl.h>
 #include <termios.h>
-#include <sys/time.h>
+#include <time.h>
+#include <poll.h>
 #include <linux/serial.h>
 #include <sys/ioctl.h>
 #include "LinuxArbotixPro.h"
@@ -26,10 +27,9 @@ LinuxArbotixPro::LinuxArbotixPro(const char* name)
 	m_UpdateStartTime = 0;
 	m_UpdateWaitTime = 0;
 	m_ByteTransferTime = 0;
-
-	sem_init(&m_LowSemID, 0, 1);
-	sem_init(&m_MidSemID, 0, 1);
-	sem_init(&m_HighSemID, 0, 1);
+	m_LowLatency = false;
+	m_LatencyPath[0] = '\0';
+	m_LatencyTimer[0] = '\0';
 
 	SetPortName(name);
 }
@@ -94,6 +94,9 @@ bool LinuxArbotixPro::OpenPort()
 
 	tcflush(m_Socket_fd, TCIFLUSH);
 
+	if (m_LowLatency == true)
+		SetPortLowLatency();
+
 	m_ByteTransferTime = (1000.0 / baudrate) * 12.0;
 
 	return true;
@@ -105,6 +108,57 @@ UART_OPEN_ERROR:
 	return false;
 }
 
+void LinuxArbotixPro::SetPortLowLatency()
+{
+	struct serial_struct serinfo;
+
+	// Ask the tty layer to push received bytes up immediately
+	if (ioctl(m_Socket_fd, TIOCGSERIAL, &serinfo) == 0)
+		{
+			serinfo.flags |= ASYNC_LOW_LATENCY;
+			if (ioctl(m_Socket_fd, TIOCSSERIAL, &serinfo) < 0 && DEBUG_PRINT == true)
+				printf("Cannot set ASYNC_LOW_LATENCY\n");
+		}
+
+	// FTDI adapters hold received bytes for up to 16ms unless the latency timer is lowered
+	const char *tty = strrchr(m_PortName, '/');
+	snprintf(m_LatencyPath, sizeof(m_LatencyPath), "/sys/bus/usb-serial/devices/%s/latency_timer", tty != 0 ? tty + 1 : m_PortName);
+
+	int fd = open(m_LatencyPath, O_RDWR);
+	if (fd < 0)
+		{
+			if (DEBUG_PRINT == true)
+				printf("No latency timer at %s\n", m_LatencyPath);
+			return;
+		}
+
+	// the setting is system wide, kept to be put back on ClosePort()
+	int n = read(fd, m_LatencyTimer, sizeof(m_LatencyTimer) - 1);
+	m_LatencyTimer[(n > 0) ? n : 0] = '\0';
+	if (lseek(fd, 0, SEEK_SET) != 0 || write(fd, "1", 1) != 1)
+		{
+			m_LatencyTimer[0] = '\0';
+			if (DEBUG_PRINT == true)
+				printf("Cannot set latency timer at %s\n", m_LatencyPath);
+		}
+	close(fd);
+}
+
+void LinuxArbotixPro::RestorePortLatency()
+{
+	if (m_LatencyTimer[0] == '\0')
+		return;
+
+	int fd = open(m_LatencyPath, O_WRONLY);
+	if (fd >= 0)
+		{
+			if (write(fd, m_LatencyTimer, strlen(m_LatencyTimer)) < 0 && DEBUG_PRINT == true)
+				printf("Cannot restore latency timer at %s\n", m_LatencyPath);
+			close(fd);
+		}
+	m_LatencyTimer[0] = '\0';
+}
+
 bool LinuxArbotixPro::SetBaud(int baud)
 {
 	struct serial_struct serinfo;
@@ -142,6 +196,7 @@ void LinuxArbotixPro::ClosePort()
 	if (m_Socket_fd != -1)
 		close(m_Socket_fd);
 	m_Socket_fd = -1;
+	RestorePortLatency();
 }
 
 void LinuxArbotixPro::FlushPort()
@@ -162,45 +217,50 @@ int LinuxArbotixPro::WritePort(unsigned char* packet, int numPacket)
 
 int LinuxArbotixPro::ReadPort(unsigned char* packet, int numPacket)
 {
-	return read(m_Socket_fd, packet, numPacket);
-}
+	int length = read(m_Socket_fd, packet, numPacket);
+	if (length > 0)
+		return length;
 
-void LinuxArbotixPro::LowPriorityWait()
-{
-	sem_wait(&m_LowSemID);
-}
+	// Nothing buffered yet: sleep until bytes arrive or the packet deadline passes
+	double remain = m_PacketStartTime + m_PacketWaitTime - GetCurrentTime();
+	if (remain <= 0)
+		return 0;
 
-void LinuxArbotixPro::MidPriorityWait()
-{
-	sem_wait(&m_MidSemID);
-}
+	struct pollfd fds;
+	struct timespec timeout;
 
-void LinuxArbotixPro::HighPriorityWait()
-{
-	sem_wait(&m_HighSemID);
-}
+	fds.fd = m_Socket_fd;
+	fds.events = POLLIN;
+	fds.revents = 0;
+	timeout.tv_sec = (time_t)(remain / 1000.0);
+	timeout.tv_nsec = (long)((remain - timeout.tv_sec * 1000.0) * 1000000.0);
 
-void LinuxArbotixPro::LowPriorityRelease()
-{
-	sem_post(&m_LowSemID);
+	if (ppoll(&fds, 1, &timeout, NULL) <= 0)
+		return 0;
+
+	length = read(m_Socket_fd, packet, numPacket);
+	if (length < 0)
+		return 0;
+
+	return length;
 }
 
-void LinuxArbotixPro::MidPriorityRelease()
+void LinuxArbotixPro::AcquireBus(int priority, double duration)
 {
-	sem_post(&m_MidSemID);
+	m_Arbiter.Acquire(priority, duration);
 }
 
-void LinuxArbotixPro::HighPriorityRelease()
+void LinuxArbotixPro::ReleaseBus(int priority)
 {
-	sem_post(&m_HighSemID);
+	m_Arbiter.Release(priority);
 }
 
 double LinuxArbotixPro::GetCurrentTime()
 {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-	return ((double)tv.tv_sec * 1000.0 + (double)tv.tv_usec / 1000.0);
+	return ((double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0);
 }
 
 void LinuxArbotixPro::SetPacketTimeout(int lenPacket)
@@ -0,0 +1,924 @@
+/*
+ *   LinuxArbotixProEmulator.cpp
+ *
+ *   In-process emulation of the Arbotix Pro (ID 200) and its Dynamixel bus
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "AXDXL.h"
+#include "LinuxArbotixProEmulator.h"
+
+using namespace Robot;
+
+
+static const int INSTRUCTION_ERROR = ArbotixPro::INSTRUCTION;
+
+#define ID					(2)
+#define LENGTH				(3)
+#define INSTRUCTION			(4)
+#define PARAMETER			(5)
+
+#define INST_PING			(1)
+#define INST_READ			(2)
+#define INST_WRITE			(3)
+#define INST_REG_WRITE		(4)
+#define INST_ACTION			(5)
+#define INST_RESET			(6)
+#define INST_SYNC_WRITE		(131)   // 0x83
+#define INST_BULK_READ      (146)   // 0x92
+#define INST_FAST_BULK_READ (154)   // 0x9A, Protocol 2.0
+#define INST_STATUS         (85)    // 0x55, Protocol 2.0
+
+#define HEADER_LENGTH2		(7)     // FF FF FD 00 ID LEN_L LEN_H
+
+#define BAUD_TOLERANCE		(0.03)  // Dynamixel accepts +-3% baudrate error
+
+
+LinuxArbotixProEmulator::Device::Device() :
+	present(false),
+	is_servo(false),
+	model(0),
+	num_address(0),
+	registered_addr(-1),
+	registered_len(0),
+	position(0),
+	velocity(0),
+	active_goal(0),
+	pending_goal(0),
+	pending_time(0)
+{
+	memset(table, 0, sizeof(table));
+	memset(registered, 0, sizeof(registered));
+}
+
+LinuxArbotixProEmulator::LinuxArbotixProEmulator(int model)
+{
+	DEBUG_PRINT = false;
+	m_Baudrate = 1000000.0;
+	m_ByteTransferTime = (1000.0 / m_Baudrate) * 10.0;
+	m_BusFreeTime = 0;
+	m_TxEndTime = 0;
+	m_LastDynamicsTime = 0;
+	m_ActuationDelay = 2.0;
+	m_ProcessingTime = 0.05;
+	m_RxHead = 0;
+	m_RxTail = 0;
+	m_PacketStartTime = 0;
+	m_PacketWaitTime = 0;
+	m_UpdateStartTime = 0;
+	m_UpdateWaitTime = 0;
+	m_Opened = false;
+	m_Protocol = ArbotixPro::PROTOCOL_1;
+
+	pthread_mutex_init(&m_Mutex, NULL);
+
+	ResetDevice(ArbotixPro::ID_CM, MODEL_CM);
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		ResetDevice(id, model);
+}
+
+LinuxArbotixProEmulator::~LinuxArbotixProEmulator()
+{
+	ClosePort();
+	pthread_mutex_destroy(&m_Mutex);
+}
+
+double LinuxArbotixProEmulator::GetCurrentTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0);
+}
+
+void LinuxArbotixProEmulator::WaitUntil(double time)
+{
+	double wait = time - GetCurrentTime();
+	if (wait <= 0)
+		return;
+
+	struct timespec ts;
+	ts.tv_sec = (time_t)(wait / 1000.0);
+	ts.tv_nsec = (long)((wait - ts.tv_sec * 1000.0) * 1000000.0);
+	nanosleep(&ts, NULL);
+}
+
+void LinuxArbotixProEmulator::ResetDevice(int id, int model)
+{
+	Device *dev = &m_Device[id];
+
+	*dev = Device();
+	dev->present = true;
+	dev->model = model;
+	dev->table[ArbotixPro::P_MODEL_NUMBER_L] = ArbotixPro::GetLowByte(model);
+	dev->table[ArbotixPro::P_MODEL_NUMBER_H] = ArbotixPro::GetHighByte(model);
+	dev->table[ArbotixPro::P_ID] = id;
+	dev->table[ArbotixPro::P_BAUD_RATE] = 1;			// 1Mbps
+	dev->table[ArbotixPro::P_RETURN_DELAY_TIME] = 0;
+	dev->table[ArbotixPro::P_RETURN_LEVEL] = 2;
+
+	if (model == MODEL_CM)
+		{
+			dev->is_servo = false;
+			dev->num_address = ArbotixPro::MAXNUM_ADDRESS;
+			dev->table[ArbotixPro::P_VERSION] = 1;
+			dev->table[ArbotixPro::P_DXL_POWER] = 0;
+			for (int addr = ArbotixPro::P_GYRO_Z_L; addr <= ArbotixPro::P_ACCEL_Z_L; addr += 2)
+				{
+					dev->table[addr] = ArbotixPro::GetLowByte(512);
+					dev->table[addr + 1] = ArbotixPro::GetHighByte(512);
+				}
+			// standing upright, 1g on the z axis
+			dev->table[ArbotixPro::P_ACCEL_Z_L] = ArbotixPro::GetLowByte(640);
+			dev->table[ArbotixPro::P_ACCEL_Z_H] = ArbotixPro::GetHighByte(640);
+			dev->table[ArbotixPro::P_VOLTAGE] = 120;
+			return;
+		}
+
+	int max_value = (model == MODEL_MX28) ? 4095 : AXDXL::MAX_VALUE;
+	int center = (max_value + 1) / 2;
+
+	dev->is_servo = true;
+	dev->num_address = AXDXL::MAXNUM_ADDRESS;
+	dev->table[AXDXL::P_VERSION] = (model == MODEL_MX28) ? 30 : 24;
+	dev->table[AXDXL::P_CCW_ANGLE_LIMIT_L] = ArbotixPro::GetLowByte(max_value);
+	dev->table[AXDXL::P_CCW_ANGLE_LIMIT_H] = ArbotixPro::GetHighByte(max_value);
+	dev->table[AXDXL::P_HIGH_LIMIT_TEMPERATURE] = 70;
+	dev->table[AXDXL::P_LOW_LIMIT_VOLTAGE] = 60;
+	dev->table[AXDXL::P_HIGH_LIMIT_VOLTAGE] = 140;
+	dev->table[AXDXL::P_MAX_TORQUE_L] = ArbotixPro::GetLowByte(1023);
+	dev->table[AXDXL::P_MAX_TORQUE_H] = ArbotixPro::GetHighByte(1023);
+	dev->table[AXDXL::P_ALARM_LED] = 36;
+	dev->table[AXDXL::P_ALARM_SHUTDOWN] = 36;
+	dev->table[AXDXL::P_CW_COMPLIANCE_MARGIN] = 1;
+	dev->table[AXDXL::P_CCW_COMPLIANCE_MARGIN] = 1;
+	dev->table[AXDXL::P_CW_COMPLIANCE_SLOPE] = JointData::SLOPE_DEFAULT;
+	dev->table[AXDXL::P_CCW_COMPLIANCE_SLOPE] = JointData::SLOPE_DEFAULT;
+	dev->table[AXDXL::P_GOAL_POSITION_L] = ArbotixPro::GetLowByte(center);
+	dev->table[AXDXL::P_GOAL_POSITION_H] = ArbotixPro::GetHighByte(center);
+	dev->table[AXDXL::P_TORQUE_LIMIT_L] = ArbotixPro::GetLowByte(1023);
+	dev->table[AXDXL::P_TORQUE_LIMIT_H] = ArbotixPro::GetHighByte(1023);
+	dev->table[AXDXL::P_PRESENT_POSITION_L] = ArbotixPro::GetLowByte(center);
+	dev->table[AXDXL::P_PRESENT_POSITION_H] = ArbotixPro::GetHighByte(center);
+	dev->table[AXDXL::P_PRESENT_VOLTAGE] = 120;
+	dev->table[AXDXL::P_PRESENT_TEMPERATURE] = 35;
+	dev->table[AXDXL::P_PUNCH_L] = 32;
+
+	dev->position = center;
+	dev->active_goal = center;
+	dev->pending_goal = center;
+}
+
+void LinuxArbotixProEmulator::SetServoPresent(int id, bool present)
+{
+	if (id < 0 || id >= ArbotixPro::ID_BROADCAST)
+		return;
+
+	pthread_mutex_lock(&m_Mutex);
+	m_Device[id].present = present;
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+bool LinuxArbotixProEmulator::GetServoPresent(int id)
+{
+	if (id < 0 || id >= ArbotixPro::ID_BROADCAST)
+		return false;
+
+	return m_Device[id].present;
+}
+
+void LinuxArbotixProEmulator::SetServoModel(int id, int model)
+{
+	if (id < 0 || id >= ArbotixPro::ID_BROADCAST || id == ArbotixPro::ID_CM)
+		return;
+
+	pthread_mutex_lock(&m_Mutex);
+	ResetDevice(id, model);
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+int LinuxArbotixProEmulator::GetTableByte(int id, int address)
+{
+	if (id < 0 || id >= ArbotixPro::ID_BROADCAST || address < 0 || address >= ArbotixPro::MAXNUM_ADDRESS)
+		return -1;
+
+	pthread_mutex_lock(&m_Mutex);
+	UpdateDynamics(GetCurrentTime());
+	int value = m_Device[id].table[address];
+	pthread_mutex_unlock(&m_Mutex);
+
+	return value;
+}
+
+void LinuxArbotixProEmulator::SetTableByte(int id, int address, int value)
+{
+	if (id < 0 || id >= ArbotixPro::ID_BROADCAST || address < 0 || address >= ArbotixPro::MAXNUM_ADDRESS)
+		return;
+
+	pthread_mutex_lock(&m_Mutex);
+	m_Device[id].table[address] = (unsigned char)value;
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+bool LinuxArbotixProEmulator::IsServoPowered()
+{
+	return m_Device[ArbotixPro::ID_CM].table[ArbotixPro::P_DXL_POWER] != 0;
+}
+
+void LinuxArbotixProEmulator::UpdateDynamics(double now)
+{
+	if (m_LastDynamicsTime == 0)
+		m_LastDynamicsTime = now;
+
+	double dt_total = now - m_LastDynamicsTime;
+	if (dt_total <= 0)
+		return;
+
+	bool powered = IsServoPowered();
+
+	for (int id = 0; id < ArbotixPro::ID_BROADCAST; id++)
+		{
+			Device *dev = &m_Device[id];
+			if (dev->is_servo == false || dev->present == false)
+				continue;
+
+			int max_value = (dev->model == MODEL_MX28) ? 4095 : AXDXL::MAX_VALUE;
+			// no load speed at 12V: AX 59rpm, MX 55rpm (value per msec)
+			double max_speed = (dev->model == MODEL_MX28) ? (55.0 * 6.0 * 4096.0 / 360.0 / 1000.0) : (59.0 * 6.0 * 1024.0 / 300.0 / 1000.0);
+			double unit_speed = (dev->model == MODEL_MX28) ? (0.114 * 6.0 * 4096.0 / 360.0 / 1000.0) : (0.111 * 6.0 * 1024.0 / 300.0 / 1000.0);
+			int moving_speed = ArbotixPro::MakeWord(dev->table[AXDXL::P_MOVING_SPEED_L], dev->table[AXDXL::P_MOVING_SPEED_H]) & 0x3FF;
+			int torque_limit = ArbotixPro::MakeWord(dev->table[AXDXL::P_TORQUE_LIMIT_L], dev->table[AXDXL::P_TORQUE_LIMIT_H]);
+			int slope = dev->table[AXDXL::P_CW_COMPLIANCE_SLOPE] > 0 ? dev->table[AXDXL::P_CW_COMPLIANCE_SLOPE] : 1;
+			double speed_limit = (moving_speed == 0) ? max_speed : moving_speed * unit_speed;
+			if (speed_limit > max_speed)
+				speed_limit = max_speed;
+			speed_limit *= (double)torque_limit / 1023.0;
+			double tau = slope / 4.0; // msec
+
+			bool active = powered && dev->table[AXDXL::P_TORQUE_ENABLE] != 0 && torque_limit > 0;
+
+			double t = m_LastDynamicsTime;
+			double remain = dt_total;
+			while (remain > 0)
+				{
+					double dt = remain > 1.0 ? 1.0 : remain;
+					t += dt;
+					remain -= dt;
+
+					if (t >= dev->pending_time)
+						dev->active_goal = dev->pending_goal;
+
+					if (active == false)
+						{
+							dev->velocity = 0;
+							continue;
+						}
+
+					double err = dev->active_goal - dev->position;
+					double v = err / tau;
+					if (v > speed_limit) v = speed_limit;
+					if (v < -speed_limit) v = -speed_limit;
+					dev->velocity = v;
+					dev->position += v * dt;
+				}
+
+			if (dev->position < 0) dev->position = 0;
+			if (dev->position > max_value) dev->position = max_value;
+
+			int pos = (int)(dev->position + 0.5);
+			int speed = (int)(fabs(dev->velocity) / unit_speed);
+			if (speed > 1023) speed = 1023;
+			if (dev->velocity < 0) speed |= 0x400;
+			int err = dev->active_goal - pos;
+			int load = abs(err) * 8;
+			if (load > 1023) load = 1023;
+			if (err < 0) load |= 0x400;
+			if (active == false) load = 0;
+
+			dev->table[AXDXL::P_PRESENT_POSITION_L] = ArbotixPro::GetLowByte(pos);
+			dev->table[AXDXL::P_PRESENT_POSITION_H] = ArbotixPro::GetHighByte(pos);
+			dev->table[AXDXL::P_PRESENT_SPEED_L] = ArbotixPro::GetLowByte(speed);
+			dev->table[AXDXL::P_PRESENT_SPEED_H] = ArbotixPro::GetHighByte(speed);
+			dev->table[AXDXL::P_PRESENT_LOAD_L] = ArbotixPro::GetLowByte(load);
+			dev->table[AXDXL::P_PRESENT_LOAD_H] = ArbotixPro::GetHighByte(load);
+			dev->table[AXDXL::P_PRESENT_VOLTAGE] = m_Device[ArbotixPro::ID_CM].table[ArbotixPro::P_VOLTAGE];
+			dev->table[AXDXL::P_MOVING] = (abs(err) > dev->table[AXDXL::P_CW_COMPLIANCE_MARGIN]) ? 1 : 0;
+		}
+
+	m_LastDynamicsTime = now;
+}
+
+void LinuxArbotixProEmulator::ApplyWrite(int id, int address, unsigned char *data, int length)
+{
+	Device *dev = &m_Device[id];
+
+	for (int i = 0; i < length; i++)
+		{
+			int addr = address + i;
+			// model number and version are read only
+			if (addr <= ArbotixPro::P_VERSION)
+				continue;
+			if (dev->is_servo == true && addr >= AXDXL::P_PRESENT_POSITION_L && addr <= AXDXL::P_MOVING)
+				continue;
+			if (dev->is_servo == false && addr >= ArbotixPro::P_BUTTON)
+				continue;
+			dev->table[addr] = data[i];
+		}
+
+	if (dev->is_servo == true)
+		{
+			if (address <= AXDXL::P_GOAL_POSITION_H && address + length > AXDXL::P_GOAL_POSITION_L)
+				{
+					dev->pending_goal = ArbotixPro::MakeWord(dev->table[AXDXL::P_GOAL_POSITION_L], dev->table[AXDXL::P_GOAL_POSITION_H]);
+					dev->pending_time = m_TxEndTime + m_ActuationDelay;
+					// writing a goal position enables the torque
+					dev->table[AXDXL::P_TORQUE_ENABLE] = 1;
+				}
+		}
+
+	int new_id = dev->table[ArbotixPro::P_ID];
+	if (new_id != id && new_id < ArbotixPro::ID_BROADCAST && new_id != ArbotixPro::ID_CM)
+		{
+			m_Device[new_id] = *dev;
+			dev->present = false;
+		}
+}
+
+void LinuxArbotixProEmulator::QueueByte(unsigned char value, double time)
+{
+	int next = (m_RxHead + 1) % MAXNUM_RXBUFFER;
+	if (next == m_RxTail)
+		return; // overrun, the byte is lost
+
+	m_RxBuffer[m_RxHead] = value;
+	m_RxTime[m_RxHead] = time;
+	m_RxHead = next;
+}
+
+double LinuxArbotixProEmulator::QueueStatus(int id, int error, unsigned char *param, int length, double start)
+{
+	unsigned char packet[ArbotixPro::MAXNUM_ADDRESS + 6];
+	unsigned char checksum = 0;
+
+	// a Fast Bulk Read status from the broadcast ID has no return delay of its own
+	if (id < ArbotixPro::ID_BROADCAST)
+		start += m_Device[id].table[ArbotixPro::P_RETURN_DELAY_TIME] * 0.002;
+	start += m_ProcessingTime;
+
+	if (m_Protocol == ArbotixPro::PROTOCOL_2)
+		{
+			unsigned char packet2[MAXNUM_RXBUFFER];
+			int stuffing = 0;
+			int n = HEADER_LENGTH2;
+
+			if ((length + 2) * 4 / 3 + HEADER_LENGTH2 + 2 > MAXNUM_RXBUFFER)
+				return start;
+
+			packet2[0] = 0xFF;
+			packet2[1] = 0xFF;
+			packet2[2] = 0xFD;
+			packet2[3] = 0x00;
+			packet2[4] = (unsigned char)id;
+			for (int i = -2; i < length; i++)
+				{
+					unsigned char data = (i == -2) ? INST_STATUS : (i == -1) ? (unsigned char)error : param[i];
+					packet2[n++] = data;
+					if (data == 0xFF)
+						stuffing = (stuffing == 1 || stuffing == 2) ? 2 : 1;
+					else if (data == 0xFD && stuffing == 2)
+						{
+							packet2[n++] = 0xFD;
+							stuffing = 0;
+						}
+					else
+						stuffing = 0;
+				}
+			packet2[5] = ArbotixPro::GetLowByte(n - HEADER_LENGTH2 + 2);
+			packet2[6] = ArbotixPro::GetHighByte(n - HEADER_LENGTH2 + 2);
+			unsigned short crc = ArbotixPro::UpdateCRC(0, packet2, n);
+			packet2[n++] = ArbotixPro::GetLowByte(crc);
+			packet2[n++] = ArbotixPro::GetHighByte(crc);
+
+			for (int i = 0; i < n; i++)
+				QueueByte(packet2[i], start + (i + 1) * m_ByteTransferTime);
+
+			return start + n * m_ByteTransferTime;
+		}
+
+	packet[0] = 0xFF;
+	packet[1] = 0xFF;
+	packet[ID] = (unsigned char)id;
+	packet[LENGTH] = (unsigned char)(length + 2);
+	packet[INSTRUCTION] = (unsigned char)error;
+	for (int i = 0; i < length; i++)
+		packet[PARAMETER + i] = param[i];
+	for (int i = 2; i < PARAMETER + length; i++)
+		checksum += packet[i];
+	packet[PARAMETER + length] = ~checksum;
+
+	for (int i = 0; i < length + 6; i++)
+		QueueByte(packet[i], start + (i + 1) * m_ByteTransferTime);
+
+	return start + (length + 6) * m_ByteTransferTime;
+}
+
+void LinuxArbotixProEmulator::ProcessPacket2(unsigned char *packet2, int length, double time)
+{
+	unsigned char body[MAXNUM_RXBUFFER];
+	unsigned char packet[MAXNUM_TXPARAM + 10];
+	unsigned char checksum = 0;
+	int num = 0;
+	int stuffing = 0;
+
+	// remove the byte stuffing of the instruction and parameters
+	for (int i = HEADER_LENGTH2; i < length - 2; i++)
+		{
+			unsigned char data = packet2[i];
+			if (stuffing == 3 && data == 0xFD)
+				{
+					stuffing = 0;
+					continue;
+				}
+			if (data == 0xFF)
+				stuffing = (stuffing == 1 || stuffing == 2) ? 2 : 1;
+			else if (data == 0xFD && stuffing == 2)
+				stuffing = 3;
+			else
+				stuffing = 0;
+			body[num++] = data;
+		}
+	if (num < 1)
+		return;
+
+	unsigned short crc = ArbotixPro::UpdateCRC(0, packet2, length - 2);
+	bool crc_ok = (packet2[length - 2] == ArbotixPro::GetLowByte(crc) && packet2[length - 1] == ArbotixPro::GetHighByte(crc));
+
+	// back to the Protocol 1.0 layout, an address above 255 is out of range
+	int inst = body[0];
+	unsigned char *p = &body[1];
+	int np = num - 1;
+	int n = 0;
+
+	switch (inst)
+		{
+		case INST_READ:
+			if (np < 4)
+				return;
+			packet[PARAMETER + n++] = (p[1] != 0) ? 0xFF : p[0];
+			packet[PARAMETER + n++] = p[2];
+			break;
+
+		case INST_WRITE:
+		case INST_REG_WRITE:
+			if (np < 2 || np > MAXNUM_TXPARAM)
+				return;
+			packet[PARAMETER + n++] = (p[1] != 0) ? 0xFF : p[0];
+			for (int i = 2; i < np; i++)
+				packet[PARAMETER + n++] = p[i];
+			break;
+
+		case INST_SYNC_WRITE:
+			if (np < 4 || np > MAXNUM_TXPARAM)
+				return;
+			packet[PARAMETER + n++] = (p[1] != 0) ? 0xFF : p[0];
+			packet[PARAMETER + n++] = p[2];
+			for (int i = 4; i < np; i++)
+				packet[PARAMETER + n++] = p[i];
+			break;
+
+		case INST_BULK_READ:
+		case INST_FAST_BULK_READ:
+			// (id, address, length) -> (length, id, address)
+			inst = INST_BULK_READ;
+			packet[PARAMETER + n++] = 0;
+			for (int i = 0; i + 5 <= np && n + 3 < MAXNUM_TXPARAM; i += 5)
+				{
+					packet[PARAMETER + n++] = p[i + 3];
+					packet[PARAMETER + n++] = p[i];
+					packet[PARAMETER + n++] = (p[i + 2] != 0) ? 0xFF : p[i + 1];
+				}
+			break;
+
+		default:
+			if (np > MAXNUM_TXPARAM)
+				return;
+			for (int i = 0; i < np; i++)
+				packet[PARAMETER + n++] = p[i];
+			break;
+		}
+	if (n + 2 > 255)
+		return;
+
+	packet[0] = 0xFF;
+	packet[1] = 0xFF;
+	packet[ID] = packet2[4];
+	packet[LENGTH] = (unsigned char)(n + 2);
+	packet[INSTRUCTION] = (unsigned char)inst;
+	for (int i = 2; i < PARAMETER + n; i++)
+		checksum += packet[i];
+	packet[PARAMETER + n] = crc_ok ? (unsigned char)~checksum : checksum;
+
+	ProcessPacket(packet, time);
+}
+
+void LinuxArbotixProEmulator::ProcessPacket(unsigned char *packet, double time)
+{
+	int id = packet[ID];
+	int length = packet[LENGTH];
+	int inst = packet[INSTRUCTION];
+	unsigned char checksum = 0;
+
+	for (int i = 2; i < length + 3; i++)
+		checksum += packet[i];
+	checksum = ~checksum;
+
+	UpdateDynamics(time);
+
+	if (id == ArbotixPro::ID_BROADCAST)
+		{
+			if (checksum != packet[length + 3])
+				return;
+
+			if (inst == INST_WRITE || inst == INST_REG_WRITE)
+				{
+					for (int i = 0; i < ArbotixPro::ID_BROADCAST; i++)
+						{
+							Device *dev = &m_Device[i];
+							if (dev->present == false || (dev->is_servo == true && IsServoPowered() == false))
+								continue;
+							if (fabs(2000000.0 / (dev->table[ArbotixPro::P_BAUD_RATE] + 1) - m_Baudrate) > m_Baudrate * BAUD_TOLERANCE)
+								continue;
+							int addr = packet[PARAMETER];
+							int len = length - 3;
+							if (addr + len > dev->num_address)
+								continue;
+							if (inst == INST_WRITE)
+								ApplyWrite(i, addr, &packet[PARAMETER + 1], len);
+							else
+								{
+									memcpy(dev->registered, &packet[PARAMETER + 1], len);
+									dev->registered_addr = addr;
+									dev->registered_len = len;
+								}
+						}
+				}
+			else if (inst == INST_ACTION)
+				{
+					for (int i = 0; i < ArbotixPro::ID_BROADCAST; i++)
+						{
+							Device *dev = &m_Device[i];
+							if (dev->present == true && dev->registered_addr >= 0)
+								{
+									ApplyWrite(i, dev->registered_addr, dev->registered, dev->registered_len);
+									dev->registered_addr = -1;
+								}
+						}
+				}
+			else if (inst == INST_SYNC_WRITE)
+				{
+					int addr = packet[PARAMETER];
+					int each = packet[PARAMETER + 1] + 1;
+					for (int n = PARAMETER + 2; n + each <= length + 3; n += each)
+						{
+							int _id = packet[n];
+							if (_id >= ArbotixPro::ID_BROADCAST || m_Device[_id].present == false)
+								continue;
+							if (m_Device[_id].is_servo == true && IsServoPowered() == false)
+								continue;
+							if (addr + each - 1 > m_Device[_id].num_address)
+								continue;
+							ApplyWrite(_id, addr, &packet[n + 1], each - 1);
+						}
+				}
+			else if (inst == INST_BULK_READ)
+				{
+					// every device answers after the previous one in the list,
+					// with Protocol 2.0 all of them in one Fast Bulk Read status
+					// (ERR ID DATA CRC per device, the last CRC is the packet's)
+					double start = time;
+					unsigned char fast[MAXNUM_RXBUFFER];
+					int fast_length = 0;
+					bool complete = true;
+					for (int n = PARAMETER + 1; n + 3 <= length + 3; n += 3)
+						{
+							int _len = packet[n];
+							int _id = packet[n + 1];
+							int _addr = packet[n + 2];
+							Device *dev = &m_Device[_id];
+
+							if (_id >= ArbotixPro::ID_BROADCAST || dev->present == false
+									|| (dev->is_servo == true && IsServoPowered() == false)
+									|| fabs(2000000.0 / (dev->table[ArbotixPro::P_BAUD_RATE] + 1) - m_Baudrate) > m_Baudrate * BAUD_TOLERANCE)
+								{
+									complete = false;
+									break; // the rest of the chain waits forever
+								}
+
+							if (m_Protocol == ArbotixPro::PROTOCOL_2)
+								{
+									if (fast_length + _len + 4 > MAXNUM_RXBUFFER / 2)
+										{
+											complete = false;
+											break;
+										}
+									if (fast_length == 0)
+										start += dev->table[ArbotixPro::P_RETURN_DELAY_TIME] * 0.002;
+
+									unsigned char *block = &fast[fast_length];
+									bool range = (_addr + _len > dev->num_address);
+									block[0] = range ? ArbotixPro::RANGE : 0;
+									block[1] = (unsigned char)_id;
+									for (int j = 0; j < _len; j++)
+										block[2 + j] = range ? 0 : dev->table[_addr + j];
+									unsigned short crc = ArbotixPro::UpdateCRC(0, block, _len + 2);
+									block[_len + 2] = ArbotixPro::GetLowByte(crc);
+									block[_len + 3] = ArbotixPro::GetHighByte(crc);
+									fast_length += _len + 4;
+									continue;
+								}
+
+							if (_addr + _len > dev->num_address)
+								start = QueueStatus(_id, ArbotixPro::RANGE, 0, 0, start);
+							else
+								start = QueueStatus(_id, 0, &dev->table[_addr], _len, start);
+						}
+					if (m_Protocol == ArbotixPro::PROTOCOL_2 && complete == true && fast_length > 0)
+						start = QueueStatus(ArbotixPro::ID_BROADCAST, fast[0], &fast[1], fast_length - 3, start);
+					if (start > m_BusFreeTime)
+						m_BusFreeTime = start;
+				}
+			return;
+		}
+
+	if (id >= ArbotixPro::ID_BROADCAST)
+		return;
+
+	Device *dev = &m_Device[id];
+	if (dev->present == false || (dev->is_servo == true && IsServoPowered() == false))
+		return;
+	if (fabs(2000000.0 / (dev->table[ArbotixPro::P_BAUD_RATE] + 1) - m_Baudrate) > m_Baudrate * BAUD_TOLERANCE)
+		return;
+
+	int return_level = dev->table[ArbotixPro::P_RETURN_LEVEL];
+	int error = 0;
+	unsigned char param[ArbotixPro::MAXNUM_ADDRESS];
+	int param_len = 0;
+	bool reply = (return_level >= 2);
+
+	if (checksum != packet[length + 3])
+		error = ArbotixPro::CHECKSUM;
+	else
+		{
+			switch (inst)
+				{
+				case INST_PING:
+					reply = true;
+					break;
+
+				case INST_READ:
+					{
+						int addr = packet[PARAMETER];
+						int len = packet[PARAMETER + 1];
+						reply = (return_level >= 1);
+						if (addr + len > dev->num_address)
+							error = ArbotixPro::RANGE;
+						else
+							{
+								memcpy(param, &dev->table[addr], len);
+								param_len = len;
+							}
+					}
+					break;
+
+				case INST_WRITE:
+				case INST_REG_WRITE:
+					{
+						int addr = packet[PARAMETER];
+						int len = length - 3;
+						if (addr + len > dev->num_address)
+							error = ArbotixPro::RANGE;
+						else if (inst == INST_WRITE)
+							ApplyWrite(id, addr, &packet[PARAMETER + 1], len);
+						else
+							{
+								memcpy(dev->registered, &packet[PARAMETER + 1], len);
+								dev->registered_addr = addr;
+								dev->registered_len = len;
+							}
+					}
+					break;
+
+				case INST_ACTION:
+					if (dev->registered_addr >= 0)
+						{
+							ApplyWrite(id, dev->registered_addr, dev->registered, dev->registered_len);
+							dev->registered_addr = -1;
+						}
+					break;
+
+				case INST_RESET:
+					ResetDevice(id, dev->model);
+					break;
+
+				default:
+					error = INSTRUCTION_ERROR;
+					break;
+				}
+		}
+
+	if (reply == true)
+		{
+			double end = QueueStatus(id, error, param, param_len, time);
+			if (end > m_BusFreeTime)
+				m_BusFreeTime = end;
+		}
+
+}
+
+bool LinuxArbotixProEmulator::OpenPort()
+{
+	pthread_mutex_lock(&m_Mutex);
+	m_Opened = true;
+	m_Baudrate = 1000000.0;
+	m_ByteTransferTime = (1000.0 / m_Baudrate) * 10.0;
+	m_RxHead = m_RxTail = 0;
+	pthread_mutex_unlock(&m_Mutex);
+
+	if (DEBUG_PRINT == true)
+		printf("\nEmulated Arbotix Pro open %.1fbps\n", m_Baudrate);
+
+	return true;
+}
+
+bool LinuxArbotixProEmulator::SetBaud(int baud)
+{
+	if (m_Opened == false)
+		return false;
+
+	pthread_mutex_lock(&m_Mutex);
+	m_Baudrate = 2000000.0 / (double)(baud + 1);
+	m_ByteTransferTime = (1000.0 / m_Baudrate) * 10.0;
+	m_RxHead = m_RxTail = 0;
+	pthread_mutex_unlock(&m_Mutex);
+
+	return true;
+}
+
+void LinuxArbotixProEmulator::ClosePort()
+{
+	m_Opened = false;
+}
+
+void LinuxArbotixProEmulator::ClearPort()
+{
+	double now = GetCurrentTime();
+
+	pthread_mutex_lock(&m_Mutex);
+	while (m_RxTail != m_RxHead && m_RxTime[m_RxTail] <= now)
+		m_RxTail = (m_RxTail + 1) % MAXNUM_RXBUFFER;
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+int LinuxArbotixProEmulator::WritePort(unsigned char* packet, int numPacket)
+{
+	if (m_Opened == false)
+		return -1;
+
+	double now = GetCurrentTime();
+
+	pthread_mutex_lock(&m_Mutex);
+
+	double start = (m_BusFreeTime > now) ? m_BusFreeTime : now;
+	m_TxEndTime = start + numPacket * m_ByteTransferTime;
+	m_BusFreeTime = m_TxEndTime;
+
+	int i = 0;
+	while (m_Protocol == ArbotixPro::PROTOCOL_2 && i + HEADER_LENGTH2 + 3 <= numPacket)
+		{
+			if (packet[i] != 0xFF || packet[i + 1] != 0xFF || packet[i + 2] != 0xFD || packet[i + 3] != 0x00)
+				{
+					i++;
+					continue;
+				}
+
+			int length = ArbotixPro::MakeWord(packet[i + 5], packet[i + 6]) + HEADER_LENGTH2;
+			if (i + length > numPacket)
+				break;
+
+			ProcessPacket2(&packet[i], length, start + (i + length) * m_ByteTransferTime);
+			i += length;
+		}
+
+	while (m_Protocol == ArbotixPro::PROTOCOL_1 && i < numPacket - 5)
+		{
+			if (packet[i] != 0xFF || packet[i + 1] != 0xFF || packet[i + 2] == 0xFF)
+				{
+					i++;
+					continue;
+				}
+
+			int length = packet[i + LENGTH] + 4;
+			if (i + length > numPacket)
+				break;
+
+			ProcessPacket(&packet[i], start + (i + length) * m_ByteTransferTime);
+			i += length;
+		}
+
+	pthread_mutex_unlock(&m_Mutex);
+
+	return numPacket;
+}
+
+int LinuxArbotixProEmulator::ReadPort(unsigned char* packet, int numPacket)
+{
+	double now = GetCurrentTime();
+	int n = 0;
+
+	// Like the serial port, sleep until a byte arrives or the packet deadline passes
+	pthread_mutex_lock(&m_Mutex);
+	double next = (m_RxTail != m_RxHead) ? m_RxTime[m_RxTail] : -1;
+	pthread_mutex_unlock(&m_Mutex);
+
+	double deadline = m_PacketStartTime + m_PacketWaitTime;
+	if (next < 0 || next > deadline)
+		next = deadline;
+	if (next > now)
+		{
+			WaitUntil(next);
+			now = GetCurrentTime();
+		}
+
+	pthread_mutex_lock(&m_Mutex);
+	while (n < numPacket && m_RxTail != m_RxHead && m_RxTime[m_RxTail] <= now)
+		{
+			packet[n++] = m_RxBuffer[m_RxTail];
+			m_RxTail = (m_RxTail + 1) % MAXNUM_RXBUFFER;
+		}
+	pthread_mutex_unlock(&m_Mutex);
+
+	return n;
+}
+
+void LinuxArbotixProEmulator::FlushPort()
+{
+	WaitUntil(m_TxEndTime);
+}
+
+void LinuxArbotixProEmulator::AcquireBus(int priority, double duration)
+{
+	m_Arbiter.Acquire(priority, duration);
+}
+
+void LinuxArbotixProEmulator::ReleaseBus(int priority)
+{
+	m_Arbiter.Release(priority);
+}
+
+void LinuxArbotixProEmulator::SetPacketTimeout(int lenPacket)
+{
+	m_PacketStartTime = GetCurrentTime();
+	m_PacketWaitTime = (1000.0 / m_Baudrate) * 12.0 * (double)lenPacket + 5.0;
+}
+
+bool LinuxArbotixProEmulator::IsPacketTimeout()
+{
+	if (GetPacketTime() > m_PacketWaitTime)
+		return true;
+
+	return false;
+}
+
+double LinuxArbotixProEmulator::GetPacketTime()
+{
+	return GetCurrentTime() - m_PacketStartTime;
+}
+
+void LinuxArbotixProEmulator::SetUpdateTimeout(int msec)
+{
+	m_UpdateStartTime = GetCurrentTime();
+	m_UpdateWaitTime = msec;
+}
+
+bool LinuxArbotixProEmulator::IsUpdateTimeout()
+{
+	if (GetUpdateTime() > m_UpdateWaitTime)
+		return true;
+
+	return false;
+}
+
+double LinuxArbotixProEmulator::GetUpdateTime()
+{
+	return GetCurrentTime() - m_UpdateStartTime;
+}
+
+void LinuxArbotixProEmulator::Sleep(int Miliseconds)
+{
+	WaitUntil(GetCurrentTime() + Miliseconds);
+}
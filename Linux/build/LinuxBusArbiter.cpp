@@ -0,0 +1,180 @@
+/*
+ *   LinuxBusArbiter.cpp
+ *
+ *   Priority and deadline scheduling of Dynamixel bus transactions
+ *
+ */
+#include <time.h>
+#include "MotionModule.h"
+#include "LinuxBusArbiter.h"
+
+using namespace Robot;
+
+
+LinuxBusArbiter::LinuxBusArbiter()
+{
+	pthread_condattr_t attr;
+
+	pthread_mutex_init(&m_Mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&m_Cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	m_Busy = false;
+	for (int i = 0; i < NUM_PRIORITY; i++)
+		{
+			m_NextTicket[i] = 0;
+			m_Serving[i] = 0;
+			m_Waiting[i] = 0;
+		}
+	m_MaxDelay[PRIORITY_MOTION] = 0.0;
+	m_MaxDelay[PRIORITY_TABLE] = MotionModule::TIME_UNIT;
+	m_MaxDelay[PRIORITY_APP] = 2 * MotionModule::TIME_UNIT;
+
+	m_TickStart = -1000000.0;
+	m_TickEnd = m_TickStart;
+	m_Period = MotionModule::TIME_UNIT;
+	m_Guard = 0.5;
+
+	ResetStatistics();
+}
+
+LinuxBusArbiter::~LinuxBusArbiter()
+{
+	pthread_cond_destroy(&m_Cond);
+	pthread_mutex_destroy(&m_Mutex);
+}
+
+double LinuxBusArbiter::GetCurrentTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0);
+}
+
+bool LinuxBusArbiter::FitsIdleSlot(double now, double duration)
+{
+	// no motion tick for a while, the bus is all idle
+	if (now > m_TickStart + 2 * m_Period)
+		return true;
+
+	// the current tick is still on the bus
+	if (now < m_TickEnd)
+		return false;
+
+	return (now + duration + m_Guard <= m_TickStart + m_Period);
+}
+
+void LinuxBusArbiter::Acquire(int priority, double duration)
+{
+	double start = GetCurrentTime();
+	double deadline = start + m_MaxDelay[priority];
+	double now = start;
+	bool deferred = false;
+
+	pthread_mutex_lock(&m_Mutex);
+
+	unsigned int ticket = m_NextTicket[priority]++;
+	m_Waiting[priority]++;
+
+	while (1)
+		{
+			bool ready = (m_Busy == false && m_Serving[priority] == ticket);
+			for (int p = 0; ready == true && p < priority; p++)
+				{
+					if (m_Waiting[p] > 0)
+						ready = false;
+				}
+
+			if (ready == true && priority != PRIORITY_MOTION && now < deadline && FitsIdleSlot(now, duration) == false)
+				{
+					// wait for the end of this tick or of the next one
+					double wake = (now < m_TickEnd) ? m_TickEnd : (m_TickStart + m_Period) + (m_TickEnd - m_TickStart);
+					if (wake > deadline || wake <= now)
+						wake = deadline;
+
+					struct timespec ts;
+					ts.tv_sec = (time_t)(wake / 1000.0);
+					ts.tv_nsec = (long)((wake - (double)ts.tv_sec * 1000.0) * 1000000.0);
+					if (ts.tv_nsec >= 1000000000L)
+						{
+							ts.tv_sec++;
+							ts.tv_nsec -= 1000000000L;
+						}
+
+					deferred = true;
+					pthread_cond_timedwait(&m_Cond, &m_Mutex, &ts);
+				}
+			else if (ready == true)
+				break;
+			else
+				pthread_cond_wait(&m_Cond, &m_Mutex);
+
+			now = GetCurrentTime();
+		}
+
+	m_Waiting[priority]--;
+	m_Serving[priority]++;
+	m_Busy = true;
+
+	if (priority == PRIORITY_MOTION)
+		{
+			// the first motion transaction after a gap starts a new tick
+			if (now > m_TickEnd + 1.0)
+				{
+					double interval = now - m_TickStart;
+					if (interval < 4 * m_Period)
+						m_Period = 0.9 * m_Period + 0.1 * interval;
+					m_TickStart = now;
+				}
+			if (now + duration > m_TickEnd)
+				m_TickEnd = now + duration;
+		}
+
+	double wait = now - start;
+	m_WaitCount[priority]++;
+	m_WaitTotal[priority] += wait;
+	if (wait > m_WaitMax[priority])
+		m_WaitMax[priority] = wait;
+	if (deferred == true)
+		m_DeferCount[priority]++;
+
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+void LinuxBusArbiter::Release(int priority)
+{
+	pthread_mutex_lock(&m_Mutex);
+
+	m_Busy = false;
+	if (priority == PRIORITY_MOTION)
+		{
+			double now = GetCurrentTime();
+			if (now > m_TickEnd)
+				m_TickEnd = now;
+		}
+
+	pthread_cond_broadcast(&m_Cond);
+	pthread_mutex_unlock(&m_Mutex);
+}
+
+double LinuxBusArbiter::GetAverageWait(int priority)
+{
+	if (m_WaitCount[priority] == 0)
+		return 0.0;
+
+	return m_WaitTotal[priority] / m_WaitCount[priority];
+}
+
+void LinuxBusArbiter::ResetStatistics()
+{
+	for (int i = 0; i < NUM_PRIORITY; i++)
+		{
+			m_WaitCount[i] = 0;
+			m_DeferCount[i] = 0;
+			m_WaitTotal[i] = 0.0;
+			m_WaitMax[i] = 0.0;
+		}
+}
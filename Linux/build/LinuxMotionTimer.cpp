@@ -7,11 +7,15 @@
 
 #include "MotionModule.h"
 #include "LinuxMotionTimer.h"
+#include "LinuxRTGuard.h"
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sched.h>
 #include <sys/time.h>
 #include <sys/prctl.h>
+#include <sys/mman.h>
 
 #if defined(__arm__)
 #define __NR_ioprio_set   314
@@ -59,13 +63,35 @@ enum
 
 #define IOPRIO_CLASS_SHIFT      13
 
+#define RT_STACK_SIZE           (256 * 1024)
+#define RT_STACK_PREFAULT       (64 * 1024)// deepest the tick is expected to go
+
 using namespace Robot;
 
+// touches the pages the tick will use below the thread function
+static void prefault_stack()
+{
+  volatile unsigned char stack[RT_STACK_PREFAULT];
+
+  for (int i = 0; i < RT_STACK_PREFAULT; i += 1024)
+    stack[i] = 0;
+  (void)stack;
+}
+
 LinuxMotionTimer::LinuxMotionTimer()
 {
   this->finish_thread = false;
   this->timer_running = false;
   this->manager = NULL;
+  this->realtime = false;
+  this->priority = 49;
+  this->cpu = -1;
+  this->bus_cpu = -1;
+  this->rt_requested = 0;
+  this->rt_obtained = 0;
+  for (int i = 0; i < NUM_RT; i++)
+    this->rt_error[i] = 0;
+  this->stack_prefaulted = false;
 }
 
 void *LinuxMotionTimer::motion_timing(void *param)
@@ -83,21 +109,50 @@ void *LinuxMotionTimer::motion_timing(void *param)
   // Set I/O priority to realtime
   ioprio_set(IOPRIO_WHO_PROCESS, getpid(), (IOPRIO_CLASS_RT << 13) | 0);
 
+  if (timer->realtime == true)
+    {
+      prefault_stack();
+      timer->stack_prefaulted = true;
+    }
+
+  bool woken = false;
   while (!timer->finish_thread)
     {
+      TickStatistics *statistics = (timer->manager != NULL) ? timer->manager->GetTickStatistics() : NULL;
+
+      // how late the thread got the CPU after the period started
+      if (woken == true && statistics != NULL)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &current_time);
+          statistics->Record(TickStatistics::WAKEUP, (current_time.tv_sec - next_time.tv_sec) * 1000.0
+                             + (current_time.tv_nsec - next_time.tv_nsec) / 1000000.0);
+        }
+
       if (timer->manager != NULL)
-        timer->manager->Process();
-      // Calculate the next reachable period
+        {
+          LinuxRTGuard::Enter();
+          timer->manager->Process();
+          LinuxRTGuard::Leave();
+        }
+      // Calculate the next reachable period, as long as the manager asks for
+      long period_ns = (long)(((timer->manager != NULL) ? timer->manager->GetTickPeriod() : MotionModule::TIME_UNIT) * 1000000.0);
       clock_gettime(CLOCK_MONOTONIC, &current_time);
+      int periods = 0;
       do
         {
-          next_time.tv_sec += (next_time.tv_nsec + MotionModule::TIME_UNIT * 1000000) / 1000000000;
-          next_time.tv_nsec = (next_time.tv_nsec + MotionModule::TIME_UNIT * 1000000) % 1000000000;
+          next_time.tv_sec += (next_time.tv_nsec + period_ns) / 1000000000;
+          next_time.tv_nsec = (next_time.tv_nsec + period_ns) % 1000000000;
+          periods++;
         }
       while (current_time.tv_sec > next_time.tv_sec
              || (current_time.tv_sec == next_time.tv_sec && current_time.tv_nsec > next_time.tv_nsec));
 
+      // the tick ran past the start of the next period, which is dropped
+      if (periods > 1 && statistics != NULL)
+        statistics->RecordOverrun(periods - 1);
+
       clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_time, NULL);
+      woken = true;
     }
 
   pthread_exit(NULL);
@@ -119,12 +174,152 @@ void LinuxMotionTimer::Initialize(MotionManager* manager)
   this->manager = manager;
 }
 
+void LinuxMotionTimer::SetRealTime(bool enable, int priority, int cpu, int bus_cpu)
+{
+  this->realtime = enable;
+  this->priority = priority;
+  this->cpu = cpu;
+  this->bus_cpu = bus_cpu;
+}
+
+void LinuxMotionTimer::LoadINISettings(minIni *ini, const std::string &section)
+{
+  SetRealTime(ini->geti(section, "realtime", this->realtime ? 1 : 0) != 0,
+              ini->geti(section, "priority", this->priority),
+              ini->geti(section, "cpu", this->cpu),
+              ini->geti(section, "bus_cpu", this->bus_cpu));
+}
+
+void LinuxMotionTimer::set_rt_result(int guarantee, int error)
+{
+  for (int i = 0; i < NUM_RT; i++)
+    {
+      if (guarantee == (1 << i))
+        this->rt_error[i] = error;
+    }
+
+  this->rt_requested |= guarantee;
+  if (error == 0)
+    this->rt_obtained |= guarantee;
+  else
+    this->rt_obtained &= ~guarantee;
+}
+
+// Each guarantee is asked for on its own, so that one that is refused (no
+// CAP_SYS_NICE, RLIMIT_MEMLOCK, a CPU that does not exist) does not cost
+// the others; the thread runs in any case.
+void LinuxMotionTimer::start_realtime()
+{
+  int error;
+  struct sched_param param;
+  pthread_attr_t attr;
+  cpu_set_t set;
+
+  this->rt_requested = 0;
+  this->rt_obtained = 0;
+  this->stack_prefaulted = false;
+
+  // every page of the process, now and to come, stays in RAM
+  set_rt_result(RT_MEMORY_LOCKED, (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) ? 0 : errno);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, RT_STACK_SIZE);
+  if ((error = pthread_create(&this->thread, &attr, this->motion_timing, this)) != 0)
+    exit(-1);
+  pthread_attr_destroy(&attr);
+  this->timer_running = true;
+
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = this->priority;
+  set_rt_result(RT_FIFO, pthread_setschedparam(this->thread, SCHED_FIFO, &param));
+
+  if (this->cpu >= 0)
+    {
+      CPU_ZERO(&set);
+      CPU_SET(this->cpu, &set);
+      set_rt_result(RT_AFFINITY, pthread_setaffinity_np(this->thread, sizeof(set), &set));
+    }
+
+  // the extra ports' I/O threads take part in every tick
+  if (this->manager != NULL && this->manager->GetNumPorts() > 1)
+    {
+      error = 0;
+      for (int port = 1; port < this->manager->GetNumPorts(); port++)
+        {
+          BusWorker *worker = this->manager->GetWorker(port);
+          if (worker->IsRunning() == false)
+            continue;
+          if (error == 0)
+            error = pthread_setschedparam(worker->GetThread(), SCHED_FIFO, &param);
+          if (error == 0 && this->bus_cpu >= 0)
+            {
+              CPU_ZERO(&set);
+              CPU_SET(this->bus_cpu, &set);
+              error = pthread_setaffinity_np(worker->GetThread(), sizeof(set), &set);
+            }
+        }
+      set_rt_result(RT_BUS_THREADS, error);
+    }
+
+  for (int i = 0; i < 100 && this->stack_prefaulted == false; i++)
+    usleep(1000);
+  set_rt_result(RT_STACK, (this->stack_prefaulted == true) ? 0 : ETIMEDOUT);
+
+  PrintRealTimeStatus(stderr);
+}
+
+void LinuxMotionTimer::PrintRealTimeStatus(FILE *fp)
+{
+  fprintf(fp, " Motion timer real-time mode:\n");
+  for (int i = 0; i < NUM_RT; i++)
+    {
+      int guarantee = 1 << i;
+      char name[32];
+
+      if ((this->rt_requested & guarantee) == 0)
+        continue;
+
+      switch (guarantee)
+        {
+        case RT_MEMORY_LOCKED:
+          strcpy(name, "memory locked");
+          break;
+        case RT_FIFO:
+          sprintf(name, "SCHED_FIFO %d", this->priority);
+          break;
+        case RT_AFFINITY:
+          sprintf(name, "on CPU %d", this->cpu);
+          break;
+        case RT_STACK:
+          strcpy(name, "stack prefaulted");
+          break;
+        default:
+          if (this->bus_cpu >= 0)
+            sprintf(name, "bus threads, CPU %d", this->bus_cpu);
+          else
+            strcpy(name, "bus threads");
+          break;
+        }
+
+      if ((this->rt_obtained & guarantee) != 0)
+        fprintf(fp, "  %-24s yes\n", name);
+      else
+        fprintf(fp, "  %-24s NO (%s)\n", name, strerror(this->rt_error[i]));
+    }
+}
+
 void LinuxMotionTimer::Start(void)
 {
   int error;
   struct sched_param param;
   pthread_attr_t attr;
 
+  if (this->realtime == true)
+    {
+      start_realtime();
+      return;
+    }
+
   pthread_attr_init(&attr);
 
   error = pthread_attr_setschedpolicy(&attr, SCHED_RR);
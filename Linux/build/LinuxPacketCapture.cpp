@@ -0,0 +1,88 @@
+/*
+ *   LinuxPacketCapture.cpp
+ *
+ *   Bus capture drained to a trace file by a background thread
+ *
+ */
+#include <unistd.h>
+#include "LinuxPacketCapture.h"
+
+using namespace Robot;
+
+
+LinuxPacketCapture::LinuxPacketCapture()
+{
+	m_File = NULL;
+	m_Running = false;
+	m_Written = 0;
+}
+
+LinuxPacketCapture::~LinuxPacketCapture()
+{
+	Stop();
+}
+
+bool LinuxPacketCapture::Start(const char *path)
+{
+	unsigned char header[FILE_HEADER_SIZE];
+
+	if (m_Running == true)
+		return false;
+
+	m_File = fopen(path, "wb");
+	if (m_File == NULL)
+		return false;
+
+	// what was captured before the file was opened is not kept
+	while (Drain(m_Buffer, DRAIN_SIZE) > 0)
+		;
+
+	MakeFileHeader(header);
+	fwrite(header, 1, FILE_HEADER_SIZE, m_File);
+	m_Written = FILE_HEADER_SIZE;
+
+	m_Running = true;
+	if (pthread_create(&m_Thread, NULL, ThreadProc, this) != 0)
+		{
+			m_Running = false;
+			fclose(m_File);
+			m_File = NULL;
+			return false;
+		}
+
+	return true;
+}
+
+void LinuxPacketCapture::Stop()
+{
+	if (m_Running == false)
+		return;
+
+	m_Running = false;
+	pthread_join(m_Thread, NULL);
+
+	Write();
+	fclose(m_File);
+	m_File = NULL;
+}
+
+void LinuxPacketCapture::Write()
+{
+	int length;
+
+	while ((length = Drain(m_Buffer, DRAIN_SIZE)) > 0)
+		m_Written += fwrite(m_Buffer, 1, length, m_File);
+}
+
+void* LinuxPacketCapture::ThreadProc(void *param)
+{
+	LinuxPacketCapture *capture = (LinuxPacketCapture*)param;
+
+	while (capture->m_Running == true)
+		{
+			capture->Write();
+			usleep(DRAIN_PERIOD * 1000);
+		}
+
+	return NULL;
+}
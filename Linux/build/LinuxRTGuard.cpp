@@ -0,0 +1,301 @@
+/*
+ *   LinuxRTGuard.cpp
+ *
+ *   Debug trap for heap and blocking calls on the motion thread
+ *
+ */
+#include "LinuxRTGuard.h"
+
+using namespace Robot;
+
+
+#ifdef RT_GUARD
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+// depth of Enter() on this thread
+static __thread int rt_depth = 0;
+
+static void violation(const char *call)
+{
+	static const char prefix[] = "\n LinuxRTGuard: ";
+	static const char suffix[] = "() on the motion thread\n";
+
+	// abort() may allocate on its own
+	rt_depth = 0;
+	ssize_t written = write(2, prefix, sizeof(prefix) - 1);
+	written += write(2, call, strlen(call));
+	written += write(2, suffix, sizeof(suffix) - 1);
+	(void)written;
+	abort();
+}
+
+#define CHECK(call)		do { if (rt_depth > 0) violation(call); } while (0)
+#define CHECK_STREAM(call, stream)	do { if (rt_depth > 0 && (stream) != stderr) violation(call); } while (0)
+
+// the next definition of each call, resolved by Enter() before the first tick
+#define REAL(name)		(real_##name != 0 ? real_##name : (resolve(), real_##name))
+#define RESOLVE(name)	real_##name = (__typeof__(real_##name))dlsym(RTLD_NEXT, #name)
+
+static __typeof__(&fopen) real_fopen = 0;
+static __typeof__(&fclose) real_fclose = 0;
+static __typeof__(&fread) real_fread = 0;
+static __typeof__(&fwrite) real_fwrite = 0;
+static __typeof__(&fseek) real_fseek = 0;
+static __typeof__(&fflush) real_fflush = 0;
+static __typeof__(&fputs) real_fputs = 0;
+static __typeof__(&puts) real_puts = 0;
+static __typeof__(&vfprintf) real_vfprintf = 0;
+static __typeof__(&system) real_system = 0;
+static __typeof__(&popen) real_popen = 0;
+static __typeof__(&sleep) real_sleep = 0;
+static __typeof__(&usleep) real_usleep = 0;
+
+static void resolve()
+{
+	RESOLVE(fopen);
+	RESOLVE(fclose);
+	RESOLVE(fread);
+	RESOLVE(fwrite);
+	RESOLVE(fseek);
+	RESOLVE(fflush);
+	RESOLVE(fputs);
+	RESOLVE(puts);
+	RESOLVE(vfprintf);
+	RESOLVE(system);
+	RESOLVE(popen);
+	RESOLVE(sleep);
+	RESOLVE(usleep);
+}
+
+extern "C"
+{
+	// glibc's own allocator under the names the program links against
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t number, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+	void *__libc_memalign(size_t alignment, size_t size);
+	void *__libc_valloc(size_t size);
+	void __libc_free(void *ptr);
+
+	void *malloc(size_t size)
+	{
+		CHECK("malloc");
+		return __libc_malloc(size);
+	}
+
+	void *calloc(size_t number, size_t size)
+	{
+		CHECK("calloc");
+		return __libc_calloc(number, size);
+	}
+
+	void *realloc(void *ptr, size_t size)
+	{
+		CHECK("realloc");
+		return __libc_realloc(ptr, size);
+	}
+
+	void free(void *ptr)
+	{
+		if (ptr != 0)
+			CHECK("free");
+		__libc_free(ptr);
+	}
+
+	void *memalign(size_t alignment, size_t size)
+	{
+		CHECK("memalign");
+		return __libc_memalign(alignment, size);
+	}
+
+	void *aligned_alloc(size_t alignment, size_t size)
+	{
+		CHECK("aligned_alloc");
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void **ptr, size_t alignment, size_t size)
+	{
+		CHECK("posix_memalign");
+		if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+			return EINVAL;
+		*ptr = __libc_memalign(alignment, size);
+		return (*ptr != 0) ? 0 : ENOMEM;
+	}
+
+	void *valloc(size_t size)
+	{
+		CHECK("valloc");
+		return __libc_valloc(size);
+	}
+
+	FILE *fopen(const char *path, const char *mode)
+	{
+		CHECK("fopen");
+		return REAL(fopen)(path, mode);
+	}
+
+	int fclose(FILE *stream)
+	{
+		CHECK("fclose");
+		return REAL(fclose)(stream);
+	}
+
+	size_t fread(void *ptr, size_t size, size_t number, FILE *stream)
+	{
+		CHECK("fread");
+		return REAL(fread)(ptr, size, number, stream);
+	}
+
+	size_t fwrite(const void *ptr, size_t size, size_t number, FILE *stream)
+	{
+		CHECK_STREAM("fwrite", stream);
+		return REAL(fwrite)(ptr, size, number, stream);
+	}
+
+	int fseek(FILE *stream, long offset, int whence)
+	{
+		CHECK("fseek");
+		return REAL(fseek)(stream, offset, whence);
+	}
+
+	int fflush(FILE *stream)
+	{
+		CHECK_STREAM("fflush", stream);
+		return REAL(fflush)(stream);
+	}
+
+	int fputs(const char *s, FILE *stream)
+	{
+		CHECK_STREAM("fputs", stream);
+		return REAL(fputs)(s, stream);
+	}
+
+	int puts(const char *s)
+	{
+		CHECK("puts");
+		return REAL(puts)(s);
+	}
+
+	int vfprintf(FILE *stream, const char *format, va_list args)
+	{
+		CHECK_STREAM("vfprintf", stream);
+		return REAL(vfprintf)(stream, format, args);
+	}
+
+	int fprintf(FILE *stream, const char *format, ...)
+	{
+		va_list args;
+		int result;
+
+		CHECK_STREAM("fprintf", stream);
+		va_start(args, format);
+		result = REAL(vfprintf)(stream, format, args);
+		va_end(args);
+		return result;
+	}
+
+	int printf(const char *format, ...)
+	{
+		va_list args;
+		int result;
+
+		CHECK("printf");
+		va_start(args, format);
+		result = REAL(vfprintf)(stdout, format, args);
+		va_end(args);
+		return result;
+	}
+
+	// what -D_FORTIFY_SOURCE turns the two above into
+	int __fprintf_chk(FILE *stream, int flag, const char *format, ...)
+	{
+		va_list args;
+		int result;
+
+		CHECK_STREAM("fprintf", stream);
+		va_start(args, format);
+		result = REAL(vfprintf)(stream, format, args);
+		va_end(args);
+		return result;
+	}
+
+	int __printf_chk(int flag, const char *format, ...)
+	{
+		va_list args;
+		int result;
+
+		CHECK("printf");
+		va_start(args, format);
+		result = REAL(vfprintf)(stdout, format, args);
+		va_end(args);
+		return result;
+	}
+
+	int system(const char *command)
+	{
+		CHECK("system");
+		return REAL(system)(command);
+	}
+
+	FILE *popen(const char *command, const char *type)
+	{
+		CHECK("popen");
+		return REAL(popen)(command, type);
+	}
+
+	unsigned int sleep(unsigned int seconds)
+	{
+		CHECK("sleep");
+		return REAL(sleep)(seconds);
+	}
+
+	int usleep(useconds_t usec)
+	{
+		CHECK("usleep");
+		return REAL(usleep)(usec);
+	}
+}
+
+void LinuxRTGuard::Enter()
+{
+	// dlsym() may allocate
+	if (real_usleep == 0)
+		resolve();
+	rt_depth++;
+}
+
+void LinuxRTGuard::Leave()
+{
+	if (rt_depth > 0)
+		rt_depth--;
+}
+
+bool LinuxRTGuard::IsEnabled()
+{
+	return true;
+}
+
+#else
+
+void LinuxRTGuard::Enter()
+{
+}
+
+void LinuxRTGuard::Leave()
+{
+}
+
+bool LinuxRTGuard::IsEnabled()
+{
+	return false;
+}
+
+#endif
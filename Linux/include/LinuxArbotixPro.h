@@ -8,8 +8,8 @@
 #ifndef _LINUX_ARBOTIXPRO_H_
 #define _LINUX_ARBOTIXPRO_H_
 
-#include <semaphore.h>
 #include "ArbotixPro.h"
+#include "LinuxBusArbiter.h"
 
 
 namespace Robot
@@ -24,12 +24,14 @@ namespace Robot
 			double m_UpdateWaitTime;
 			double m_ByteTransferTime;
 			char m_PortName[20];
+			bool m_LowLatency;
+			char m_LatencyPath[64];
+			char m_LatencyTimer[8];		// the value found there, "": not changed
 
-			sem_t m_LowSemID;
-			sem_t m_MidSemID;
-			sem_t m_HighSemID;
+			LinuxBusArbiter m_Arbiter;
 
-			double GetCurrentTime();
+			void SetPortLowLatency();
+			void RestorePortLatency();
 
 		public:
 			bool DEBUG_PRINT;
@@ -40,6 +42,13 @@ namespace Robot
 			void SetPortName(const char* name);
 			const char* GetPortName()		{ return (const char*)m_PortName; }
 
+			// ASYNC_LOW_LATENCY and a 1ms FTDI latency timer, applied on OpenPort()
+			// and the timer put back on ClosePort(). Off by default.
+			void SetLowLatency(bool enable)	{ m_LowLatency = enable; }
+			bool GetLowLatency()			{ return m_LowLatency; }
+
+			LinuxBusArbiter* GetBusArbiter()	{ return &m_Arbiter; }
+
 			///////////////// Platform Porting //////////////////////
 			bool OpenPort();
 			bool SetBaud(int baud);
@@ -49,12 +58,8 @@ namespace Robot
 			int ReadPort(unsigned char* packet, int numPacket);
 			void FlushPort();
 
-			void LowPriorityWait();
-			void MidPriorityWait();
-			void HighPriorityWait();
-			void LowPriorityRelease();
-			void MidPriorityRelease();
-			void HighPriorityRelease();
+			void AcquireBus(int priority, double duration);
+			void ReleaseBus(int priority);
 
 			void SetPacketTimeout(int lenPacket);
 			bool IsPacketTimeout();
@@ -62,6 +67,7 @@ namespace Robot
 			void SetUpdateTimeout(int msec);
 			bool IsUpdateTimeout();
 			double GetUpdateTime();
+			double GetCurrentTime();
 
 			virtual void Sleep(int Miliseconds);
 			////////////////////////////////////////////////////////
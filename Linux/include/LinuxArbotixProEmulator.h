@@ -0,0 +1,139 @@
+/*
+ *   LinuxArbotixProEmulator.h
+ *
+ *   In-process emulation of the Arbotix Pro (ID 200) and its Dynamixel bus
+ *
+ */
+
+#ifndef _LINUX_ARBOTIXPRO_EMULATOR_H_
+#define _LINUX_ARBOTIXPRO_EMULATOR_H_
+
+#include <pthread.h>
+#include "ArbotixPro.h"
+#include "LinuxBusArbiter.h"
+#include "JointData.h"
+
+
+namespace Robot
+{
+	class LinuxArbotixProEmulator : public PlatformArbotixPro
+	{
+		public:
+			enum
+			{
+				MODEL_AX12		= 12,
+				MODEL_AX18		= 18,
+				MODEL_MX28		= 29,
+				MODEL_CM		= 0x7300
+			};
+
+			enum
+			{
+				MAXNUM_RXBUFFER	= 4096
+			};
+
+		private:
+			class Device
+			{
+				public:
+					bool present;
+					bool is_servo;
+					int model;
+					int num_address;
+					unsigned char table[ArbotixPro::MAXNUM_ADDRESS];
+					unsigned char registered[ArbotixPro::MAXNUM_ADDRESS];
+					int registered_addr;
+					int registered_len;
+
+					// servo dynamics
+					double position;		// present position (value)
+					double velocity;		// value per msec
+					int active_goal;
+					int pending_goal;
+					double pending_time;	// pending_goal takes effect at this time
+
+					Device();
+			};
+
+			Device m_Device[ArbotixPro::ID_BROADCAST];
+
+			double m_Baudrate;			// bps
+			double m_ByteTransferTime;	// msec per byte on the wire
+			double m_BusFreeTime;		// the wire is busy until this time
+			double m_TxEndTime;
+			double m_LastDynamicsTime;
+			double m_ActuationDelay;	// msec from goal write to motion start
+			double m_ProcessingTime;	// msec a device needs before replying
+
+			unsigned char m_RxBuffer[MAXNUM_RXBUFFER];
+			double m_RxTime[MAXNUM_RXBUFFER];
+			int m_RxHead;
+			int m_RxTail;
+
+			double m_PacketStartTime;
+			double m_PacketWaitTime;
+			double m_UpdateStartTime;
+			double m_UpdateWaitTime;
+
+			bool m_Opened;
+			int m_Protocol;				// ArbotixPro::PROTOCOL_1 or PROTOCOL_2
+
+			pthread_mutex_t m_Mutex;
+			LinuxBusArbiter m_Arbiter;
+
+			void WaitUntil(double time);
+
+			void ResetDevice(int id, int model);
+			bool IsServoPowered();
+			void UpdateDynamics(double now);
+			void ApplyWrite(int id, int address, unsigned char *data, int length);
+			void ProcessPacket(unsigned char *packet, double time);
+			void ProcessPacket2(unsigned char *packet2, int length, double time);
+			double QueueStatus(int id, int error, unsigned char *param, int length, double start);
+			void QueueByte(unsigned char value, double time);
+
+		public:
+			bool DEBUG_PRINT;
+
+			LinuxArbotixProEmulator(int model = MODEL_AX12);
+			~LinuxArbotixProEmulator();
+
+			void SetServoPresent(int id, bool present);
+			bool GetServoPresent(int id);
+			void SetServoModel(int id, int model);
+			void SetActuationDelay(double msec)		{ m_ActuationDelay = msec; }
+			void SetProcessingTime(double msec)		{ m_ProcessingTime = msec; }
+			int GetTableByte(int id, int address);
+			void SetTableByte(int id, int address, int value);
+			double GetBaudrate()					{ return m_Baudrate; }
+			// every device on the bus speaks the same protocol
+			void SetProtocol(int protocol)			{ m_Protocol = protocol; }
+			int GetProtocol()						{ return m_Protocol; }
+			LinuxBusArbiter* GetBusArbiter()		{ return &m_Arbiter; }
+
+			///////////////// Platform Porting //////////////////////
+			bool OpenPort();
+			bool SetBaud(int baud);
+			void ClosePort();
+			void ClearPort();
+			int WritePort(unsigned char* packet, int numPacket);
+			int ReadPort(unsigned char* packet, int numPacket);
+			void FlushPort();
+
+			void AcquireBus(int priority, double duration);
+			void ReleaseBus(int priority);
+
+			void SetPacketTimeout(int lenPacket);
+			bool IsPacketTimeout();
+			double GetPacketTime();
+			void SetUpdateTimeout(int msec);
+			bool IsUpdateTimeout();
+			double GetUpdateTime();
+			double GetCurrentTime();
+
+			virtual void Sleep(int Miliseconds);
+			////////////////////////////////////////////////////////
+	};
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ *   LinuxBusArbiter.h
+ *
+ *   Priority and deadline scheduling of Dynamixel bus transactions
+ *
+ */
+
+#ifndef _LINUX_BUS_ARBITER_H_
+#define _LINUX_BUS_ARBITER_H_
+
+#include <pthread.h>
+
+
+namespace Robot
+{
+	// Grants the bus to one transaction at a time.
+	// Waiting motion transactions always go first. Lower classes are served
+	// in arrival order, and only in the idle slot between two motion ticks
+	// (predicted from the motion requests seen so far), so an application
+	// read can not push the next tick back. A request that has waited past
+	// its deadline is served as soon as the bus is free.
+	class LinuxBusArbiter
+	{
+		public:
+			enum
+			{
+				PRIORITY_MOTION,
+				PRIORITY_TABLE,
+				PRIORITY_APP,
+				NUM_PRIORITY
+			};
+
+		private:
+			pthread_mutex_t m_Mutex;
+			pthread_cond_t m_Cond;
+
+			bool m_Busy;
+			unsigned int m_NextTicket[NUM_PRIORITY];
+			unsigned int m_Serving[NUM_PRIORITY];
+			int m_Waiting[NUM_PRIORITY];
+			double m_MaxDelay[NUM_PRIORITY];	// msec a request may be deferred
+
+			// motion tick prediction
+			double m_TickStart;		// first motion request of the current tick
+			double m_TickEnd;		// the motion transactions occupy the bus until then
+			double m_Period;		// msec between ticks
+			double m_Guard;			// msec kept free before a tick
+
+			// statistics
+			unsigned int m_WaitCount[NUM_PRIORITY];
+			unsigned int m_DeferCount[NUM_PRIORITY];
+			double m_WaitTotal[NUM_PRIORITY];
+			double m_WaitMax[NUM_PRIORITY];
+
+			double GetCurrentTime();
+			bool FitsIdleSlot(double now, double duration);
+
+		public:
+			LinuxBusArbiter();
+			~LinuxBusArbiter();
+
+			// duration: estimated msec the transaction keeps the bus
+			void Acquire(int priority, double duration);
+			void Release(int priority);
+
+			void SetMaxDelay(int priority, double msec)	{ m_MaxDelay[priority] = msec; }
+			void SetGuardTime(double msec)				{ m_Guard = msec; }
+			double GetTickPeriod()						{ return m_Period; }
+
+			unsigned int GetWaitCount(int priority)		{ return m_WaitCount[priority]; }
+			unsigned int GetDeferCount(int priority)	{ return m_DeferCount[priority]; }
+			double GetAverageWait(int priority);
+			double GetMaxWait(int priority)				{ return m_WaitMax[priority]; }
+			void ResetStatistics();
+	};
+}
+
+#endif
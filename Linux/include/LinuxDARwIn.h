@@ -10,7 +10,11 @@
 
 #include "DARwIn.h"
 #include "LinuxMotionTimer.h"
+#include "LinuxRTGuard.h"
 #include "LinuxArbotixPro.h"
+#include "LinuxArbotixProEmulator.h"
+#include "LinuxBusArbiter.h"
+#include "LinuxPacketCapture.h"
 #include "LinuxCamera.h"
 #include "LinuxNetwork.h"
 #include "LinuxActionScript.h"
@@ -8,14 +8,28 @@
 #ifndef _LINUX_MOTION_MANAGER_H_
 #define _LINUX_MOTION_MANAGER_H_
 
+#include <stdio.h>
 #include <pthread.h>
 #include <time.h>
+#include <string>
 #include "MotionManager.h"
 
 namespace Robot
 {
   class LinuxMotionTimer
   {
+    public:
+      // guarantees of the real-time mode, see GetRealTimeStatus()
+      enum
+      {
+        RT_MEMORY_LOCKED = 1,// mlockall(MCL_CURRENT | MCL_FUTURE)
+        RT_FIFO = 2,// SCHED_FIFO at the requested priority
+        RT_AFFINITY = 4,// timer thread pinned to its CPU
+        RT_STACK = 8,// timer stack touched before the first tick
+        RT_BUS_THREADS = 16,// bus worker threads at the same priority, on their CPU
+        NUM_RT = 5
+      };
+
     private:
       pthread_t thread;// thread structure
       struct timespec next_time;// next absolute time
@@ -23,12 +37,34 @@ namespace Robot
       bool timer_running;
       MotionManager *manager;// reference to the motion manager class.
 
+      bool realtime;
+      int priority;// SCHED_FIFO priority
+      int cpu;// CPU of the timer thread, -1: any
+      int bus_cpu;// CPU of the bus worker threads, -1: any
+      int rt_requested;
+      int rt_obtained;
+      int rt_error[NUM_RT];// errno of the guarantees not obtained
+      volatile bool stack_prefaulted;
+
     protected:
       static void *motion_timing(void *param);// thread function
       void update_time(int interval_ns);
+      void start_realtime();
+      void set_rt_result(int guarantee, int error);
     public:
       LinuxMotionTimer();
       void Initialize(MotionManager* manager);
+
+      // Opt-in real-time mode, taken by the next Start(): memory locked,
+      // stack prefaulted, SCHED_FIFO at the given priority for the timer
+      // and the bus worker threads, each pinned to a CPU when one is given.
+      // Start() then reports on stderr which guarantees were obtained.
+      // "realtime", "priority", "cpu" and "bus_cpu" in [Timer].
+      void SetRealTime(bool enable, int priority = 49, int cpu = -1, int bus_cpu = -1);
+      void LoadINISettings(minIni *ini, const std::string &section = TIMER_SECTION);
+      bool GetRealTime()                { return this->realtime; }
+      int GetRealTimeStatus()           { return this->rt_obtained; }// RT_xxx flags
+      void PrintRealTimeStatus(FILE *fp);
       void Start();
       void Stop();
       bool IsRunning();
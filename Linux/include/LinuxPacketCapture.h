@@ -0,0 +1,53 @@
+/*
+ *   LinuxPacketCapture.h
+ *
+ *   Bus capture drained to a trace file by a background thread
+ *
+ */
+
+#ifndef _LINUX_PACKET_CAPTURE_H_
+#define _LINUX_PACKET_CAPTURE_H_
+
+#include <stdio.h>
+#include <pthread.h>
+#include "PacketCapture.h"
+
+
+namespace Robot
+{
+	// Give it to ArbotixPro::SetCapture() after Start(). The thread wakes
+	// every DRAIN_PERIOD msec and writes what the ring holds; it never
+	// touches the bus, so the capture adds no more than a copy to the
+	// motion path. Read the file back with dxl_trace.
+	class LinuxPacketCapture : public PacketCapture
+	{
+		public:
+			enum
+			{
+				DRAIN_PERIOD	= 10,		// msec
+				DRAIN_SIZE		= 1 << 17
+			};
+
+		private:
+			FILE *m_File;
+			pthread_t m_Thread;
+			volatile bool m_Running;
+			unsigned long m_Written;
+			unsigned char m_Buffer[DRAIN_SIZE];
+
+			static void* ThreadProc(void *param);
+			void Write();
+
+		public:
+			LinuxPacketCapture();
+			~LinuxPacketCapture();
+
+			bool Start(const char *path);
+			// the ring is drained to the file before it is closed
+			void Stop();
+			bool IsRunning()				{ return m_Running; }
+			unsigned long GetWritten()		{ return m_Written; }
+	};
+}
+
+#endif
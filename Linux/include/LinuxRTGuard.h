@@ -0,0 +1,33 @@
+/*
+ *   LinuxRTGuard.h
+ *
+ *   Debug trap for heap and blocking calls on the motion thread
+ *
+ */
+
+#ifndef _LINUX_RT_GUARD_H_
+#define _LINUX_RT_GUARD_H_
+
+
+namespace Robot
+{
+	// LinuxMotionTimer brackets every MotionManager::Process() with Enter()
+	// and Leave(). In a build with -DRT_GUARD (see the Makefile) a thread
+	// inside that bracket which calls malloc, free or their kin (new and
+	// delete included), opens, reads, writes, seeks or flushes a stdio
+	// stream other than stderr, prints to stdout, calls sleep or usleep or
+	// runs a program gets the call named on stderr and is aborted, so the
+	// core shows where it came from. The serial port, the bus locks and
+	// the wire time of the emulator are the tick's own work and are not
+	// trapped. Without RT_GUARD both are empty.
+	class LinuxRTGuard
+	{
+		public:
+			static void Enter();
+			static void Leave();
+			// built with RT_GUARD
+			static bool IsEnabled();
+	};
+}
+
+#endif
@@ -153,7 +153,7 @@ int main(int argc, char *argv[])
     //httpd::ini = ini;
 
     //////////////////// Framework Initialize ////////////////////////////
-    if (MotionManager::GetInstance()->Initialize(&arbotixpro) == false)
+    if (MotionManager::GetInstance()->Initialize(&arbotixpro, ini) == false)
 	{
 		printf("Fail to initialize Motion Manager!\n");
 		return 0;
@@ -0,0 +1,290 @@
+/*
+ *   main.cpp
+ *
+ *   Dynamixel bus benchmark: the motion tick workload at every
+ *   candidate baud rate and servo return delay time
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include "LinuxDARwIn.h"
+
+
+#define PROGRAM_VERSION		"v1.00"
+#define INI_FILE_PATH		"../../../Data/config.ini"
+#define INI_SECTION			"Bus"
+
+#define MAXNUM_CANDIDATE	(16)
+#define DEFAULT_TICKS		(500)
+#define DEFAULT_BAUDNUMBER	(1)		// the port is opened at 1Mbps
+#define MAX_ERROR_RATE		(0.01)	// a setting dropping more ticks is not usable
+
+using namespace Robot;
+
+
+// baud number: 2000000 / (number + 1) bps
+static int gBaudList[MAXNUM_CANDIDATE] = { 1, 3, 7, 16, 34 };
+static int gNumBaud = 5;
+// P_RETURN_DELAY_TIME: 2usec unit
+static int gDelayList[MAXNUM_CANDIDATE] = { 0, 5, 25, 250 };
+static int gNumDelay = 4;
+
+static int gTicks = DEFAULT_TICKS;
+static int gBytes = 2;
+static int gProtocol = ArbotixPro::PROTOCOL_1;
+
+class Result
+{
+	public:
+		int baud;
+		int delay;
+		double ticks_per_sec;
+		double p50;
+		double p90;
+		double p99;
+		double max;
+		double error_rate;
+};
+
+void sighandler(int sig)
+{
+	exit(0);
+}
+
+static void Usage(const char *name)
+{
+	printf(" Usage: %s [options]\n", name);
+	printf("  --emulate            run against the emulated bus\n");
+	printf("  --port <device>      serial port (default /dev/ttyUSB0)\n");
+	printf("  --ticks <n>          ticks per setting (default %d)\n", DEFAULT_TICKS);
+	printf("  --bytes <n>          bulk read bytes per joint, 2 ~ 8 (default 2)\n");
+	printf("  --baud <n,n,...>     baud numbers to try (default 1,3,7,16,34)\n");
+	printf("  --delay <n,n,...>    return delay times to try (default 0,5,25,250)\n");
+	printf("  --protocol <1|2>     Dynamixel protocol (default 1)\n");
+	printf("  --save [file]        record the best setting in [%s] of the ini file,\n", INI_SECTION);
+	printf("                       the servos are set back to the default either way\n");
+	printf("                       (default %s)\n", INI_FILE_PATH);
+}
+
+static int ParseList(const char *text, int *list)
+{
+	char buffer[128];
+	int num = 0;
+
+	strncpy(buffer, text, sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = 0;
+	for (char *token = strtok(buffer, ","); token != 0 && num < MAXNUM_CANDIDATE; token = strtok(0, ","))
+		list[num++] = atoi(token);
+
+	return num;
+}
+
+static double GetTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0);
+}
+
+// smallest feedback set that reads the given number of bytes per joint
+static int GetFeedbackFields(int bytes)
+{
+	int fields = ArbotixPro::FEEDBACK_POSITION;
+
+	if (bytes > 2)
+		fields |= ArbotixPro::FEEDBACK_SPEED;
+	if (bytes > 4)
+		fields |= ArbotixPro::FEEDBACK_LOAD;
+	if (bytes > 6)
+		fields |= ArbotixPro::FEEDBACK_VOLTAGE;
+	if (bytes > 7)
+		fields |= ArbotixPro::FEEDBACK_TEMPERATURE;
+
+	return fields;
+}
+
+static bool ApplySetting(ArbotixPro *cm, int baud, int delay)
+{
+	// every device first, then the host follows
+	cm->WriteByte(ArbotixPro::ID_BROADCAST, ArbotixPro::P_RETURN_DELAY_TIME, delay, 0);
+	cm->SetReturnDelayTime(delay);
+	cm->WriteByte(ArbotixPro::ID_BROADCAST, ArbotixPro::P_BAUD_RATE, baud, 0);
+	usleep(10000);
+
+	return cm->ChangeBaud(baud);
+}
+
+static void RunWorkload(ArbotixPro *cm, int *goal, Result *result)
+{
+	int param[JointData::NUMBER_OF_JOINTS * 3];
+	int n = 0;
+	int errors = 0;
+	Histogram latency;
+
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			param[n++] = id;
+			param[n++] = ArbotixPro::GetLowByte(goal[id]);
+			param[n++] = ArbotixPro::GetHighByte(goal[id]);
+		}
+
+	cm->SetFeedback(GetFeedbackFields(gBytes));
+	cm->BulkRead();
+	latency.SetBucketWidth(cm->GetBulkReadTime() * 4.0 / Histogram::NUM_BUCKETS + 0.01);
+
+	double start = GetTime();
+	for (int tick = 0; tick < gTicks; tick++)
+		{
+			double t = GetTime();
+			int res = cm->SyncWrite(AXDXL::P_GOAL_POSITION_L, 3, JointData::NUMBER_OF_JOINTS - 1, param);
+			if (res == ArbotixPro::SUCCESS)
+				res = cm->BulkRead();
+			latency.Add(GetTime() - t);
+
+			if (res != ArbotixPro::SUCCESS)
+				errors++;
+		}
+	double elapsed = GetTime() - start;
+
+	result->ticks_per_sec = gTicks * 1000.0 / elapsed;
+	result->p50 = latency.GetPercentile(0.5);
+	result->p90 = latency.GetPercentile(0.9);
+	result->p99 = latency.GetPercentile(0.99);
+	result->max = latency.GetMax();
+	result->error_rate = (double)errors / gTicks;
+}
+
+int main(int argc, char *argv[])
+{
+	signal(SIGABRT, &sighandler);
+	signal(SIGTERM, &sighandler);
+	signal(SIGQUIT, &sighandler);
+	signal(SIGINT, &sighandler);
+
+	bool emulate = false;
+	const char *port = "/dev/ttyUSB0";
+	const char *ini_path = 0;
+
+	for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--emulate") == 0)
+				emulate = true;
+			else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+				port = argv[++i];
+			else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+				gTicks = atoi(argv[++i]);
+			else if (strcmp(argv[i], "--bytes") == 0 && i + 1 < argc)
+				gBytes = atoi(argv[++i]);
+			else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+				gNumBaud = ParseList(argv[++i], gBaudList);
+			else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc)
+				gNumDelay = ParseList(argv[++i], gDelayList);
+			else if (strcmp(argv[i], "--protocol") == 0 && i + 1 < argc)
+				gProtocol = atoi(argv[++i]);
+			else if (strcmp(argv[i], "--save") == 0)
+				ini_path = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : INI_FILE_PATH;
+			else
+				{
+					Usage(argv[0]);
+					return 0;
+				}
+		}
+
+	if (gTicks <= 0 || gBytes < 1 || gBytes > 8 || gNumBaud == 0 || gNumDelay == 0
+			|| (gProtocol != ArbotixPro::PROTOCOL_1 && gProtocol != ArbotixPro::PROTOCOL_2))
+		{
+			Usage(argv[0]);
+			return 0;
+		}
+
+	printf("\n[Dynamixel Bus Benchmark for DARwIn %s]\n", PROGRAM_VERSION);
+
+	LinuxArbotixProEmulator *emulator = 0;
+	PlatformArbotixPro *platform;
+	if (emulate == true)
+		{
+			emulator = new LinuxArbotixProEmulator();
+			emulator->SetProtocol(gProtocol);
+			platform = emulator;
+		}
+	else
+		platform = new LinuxArbotixPro(port);
+
+	ArbotixPro *cm = new ArbotixPro(platform);
+	cm->SetProtocol(gProtocol);
+	if (cm->Connect() == false)
+		{
+			fprintf(stderr, " Fail to connect the Arbotix Pro\n");
+			return 0;
+		}
+
+	// hold every joint where it is, the workload writes the same goal each tick
+	int goal[JointData::NUMBER_OF_JOINTS];
+	int original_delay = 250;
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			goal[id] = 512;
+			if (cm->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &goal[id], 0) != ArbotixPro::SUCCESS)
+				fprintf(stderr, " ID %d does not answer\n", id);
+			MotionStatus::m_CurrentJoints.SetEnable(id, true);
+		}
+	cm->ReadByte(JointData::ID_MIN, AXDXL::P_RETURN_DELAY_TIME, &original_delay, 0);
+
+	printf(" %d ticks of SyncWrite (%d joints) + BulkRead (%d bytes/joint) per setting\n\n",
+	       gTicks, JointData::NUMBER_OF_JOINTS - 1, gBytes);
+	printf(" %9s %9s %9s %9s %9s %9s %9s %8s\n", "BAUD(bps)", "DELAY(us)", "TICK/s", "P50(ms)", "P90(ms)", "P99(ms)", "MAX(ms)", "ERROR(%)");
+
+	Result best;
+	best.ticks_per_sec = 0;
+	best.baud = DEFAULT_BAUDNUMBER;
+	best.delay = original_delay;
+
+	for (int b = 0; b < gNumBaud; b++)
+		{
+			for (int d = 0; d < gNumDelay; d++)
+				{
+					Result result;
+					result.baud = gBaudList[b];
+					result.delay = gDelayList[d];
+
+					if (ApplySetting(cm, result.baud, result.delay) == false)
+						{
+							printf(" %9.0f %9d   setting failed\n", 2000000.0 / (result.baud + 1), result.delay * 2);
+							continue;
+						}
+
+					RunWorkload(cm, goal, &result);
+					printf(" %9.0f %9d %9.1f %9.3f %9.3f %9.3f %9.3f %8.2f\n",
+					       2000000.0 / (result.baud + 1), result.delay * 2, result.ticks_per_sec,
+					       result.p50, result.p90, result.p99, result.max, result.error_rate * 100.0);
+
+					if (result.error_rate <= MAX_ERROR_RATE && result.ticks_per_sec > best.ticks_per_sec)
+						best = result;
+				}
+		}
+
+	if (best.ticks_per_sec > 0)
+		printf("\n Best: %.0fbps, return delay %dusec, %.1f ticks/s\n", 2000000.0 / (best.baud + 1), best.delay * 2, best.ticks_per_sec);
+	else
+		printf("\n No setting ran within %.0f%% errors\n", MAX_ERROR_RATE * 100.0);
+
+	// the other programs open the bus at the default baud rate, so the
+	// servos are always left there; the best setting is only recorded
+	ApplySetting(cm, DEFAULT_BAUDNUMBER, original_delay);
+
+	if (ini_path != 0 && best.ticks_per_sec > 0)
+		{
+			minIni ini(ini_path);
+			ini.put(INI_SECTION, "baud_number", best.baud);
+			ini.put(INI_SECTION, "return_delay_time", best.delay);
+			printf(" Recorded in [%s] of %s (the servos are left at the default)\n", INI_SECTION, ini_path);
+		}
+
+	printf("\n");
+	return 0;
+}
@@ -116,6 +116,10 @@ void Help()
 	printf( " wr [ADDR] [VALUE] : Writes value [VALUE] to address [ADDR] of current Dynamixel\n" );
 	printf( " on/off : Turns torque on/off of current Dynamixel\n" );
 	printf( " on/off all : Turns torque on/off of all Dynamixels)\n" );
+	printf( " stat : Outputs bus statistics per instruction and Dynamixel\n" );
+	printf( " stat reset : Clears the bus statistics\n" );
+	printf( " capture [FILE] : Captures the bus traffic to [FILE] (read it with dxl_trace)\n" );
+	printf( " capture stop : Stops the capture\n" );
 	printf( "\n       Copyright ROBOTIS CO.,LTD.\n\n" );
 }
 
@@ -629,3 +633,16 @@ void Write(Robot::ArbotixPro *arbotixpro, int id, int addr, int value)
 
 	printf(" Writing successful!\n");
 }
+
+void Stat(ArbotixPro *arbotixpro, LinuxBusArbiter *arbiter)
+{
+	const char *name[LinuxBusArbiter::NUM_PRIORITY] = { "MOTION", "TABLE", "APP" };
+
+	arbotixpro->GetStatistics()->Print(stdout);
+
+	printf(" %-11s %8s %8s %8s %8s\n", "BUS WAIT", "COUNT", "DEFERRED", "AVG(ms)", "MAX(ms)");
+	for (int i = 0; i < LinuxBusArbiter::NUM_PRIORITY; i++)
+		printf(" %-11s %8u %8u %8.3f %8.3f\n", name[i], arbiter->GetWaitCount(i), arbiter->GetDeferCount(i),
+		       arbiter->GetAverageWait(i), arbiter->GetMaxWait(i));
+	printf("\n Delayed writes lost: %u\n\n", arbotixpro->GetDelayedOverflow());
+}
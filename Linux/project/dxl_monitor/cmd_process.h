@@ -11,5 +11,6 @@ void Scan(Robot::ArbotixPro *arbotixpro);
 void Dump(Robot::ArbotixPro *arbotixpro, int id);
 void Reset(Robot::ArbotixPro *arbotixpro, int id);
 void Write(Robot::ArbotixPro *arbotixpro, int id, int addr, int value);
+void Stat(Robot::ArbotixPro *arbotixpro, Robot::LinuxBusArbiter *arbiter);
 
 #endif
@@ -13,6 +13,7 @@ using namespace Robot;
 
 LinuxArbotixPro linux_arbotixpro("/dev/ttyUSB0");
 ArbotixPro arbotixpro(&linux_arbotixpro);
+LinuxPacketCapture capture;
 
 int gID = ArbotixPro::ID_CM;
 
@@ -193,6 +194,42 @@ int main()
 									continue;
 								}
 						}
+					else if (strcmp(cmd, "stat") == 0)
+						{
+							if (num_param == 0)
+								Stat(&arbotixpro, linux_arbotixpro.GetBusArbiter());
+							else if (num_param == 1 && strcmp(param[0], "reset") == 0)
+								{
+									arbotixpro.GetStatistics()->Reset();
+									linux_arbotixpro.GetBusArbiter()->ResetStatistics();
+								}
+							else
+								{
+									printf(" Invalid parameter!\n");
+									continue;
+								}
+						}
+					else if (strcmp(cmd, "capture") == 0)
+						{
+							if (num_param == 1 && strcmp(param[0], "stop") == 0)
+								{
+									arbotixpro.SetCapture(0);
+									capture.Stop();
+									printf(" %lu bytes written, %u records dropped\n", capture.GetWritten(), capture.GetDropped());
+								}
+							else if (num_param == 1 && capture.IsRunning() == false)
+								{
+									if (capture.Start(param[0]) == true)
+										arbotixpro.SetCapture(&capture);
+									else
+										printf(" Can not write %s\n", param[0]);
+								}
+							else
+								{
+									printf(" Invalid parameter!\n");
+									continue;
+								}
+						}
 					else if (strcmp(cmd, "wr") == 0)
 						{
 							if (num_param == 2)
@@ -0,0 +1,259 @@
+/*
+ *   main.cpp
+ *
+ *   Servo response calibration: a small goal step per joint, the present
+ *   position traced by bulk read and fitted to a delay and time constant
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include "LinuxDARwIn.h"
+
+
+#define PROGRAM_VERSION		"v1.00"
+#define INI_FILE_PATH		"../../../Data/config.ini"
+
+#define DEFAULT_STEP		(30)	// about 9 degrees
+#define DEFAULT_WINDOW		(250)	// msec traced after each step
+#define SETTLE_TIME			(300)	// msec before each step
+#define MAXNUM_SAMPLE		(2048)
+
+using namespace Robot;
+
+
+static int gStep = DEFAULT_STEP;
+static double gWindow = DEFAULT_WINDOW;
+static double gPeriod = MotionModule::TIME_UNIT;
+static int gProtocol = ArbotixPro::PROTOCOL_1;
+
+static double gTime[MAXNUM_SAMPLE];
+static int gPosition[MAXNUM_SAMPLE];
+
+void sighandler(int sig)
+{
+	exit(0);
+}
+
+static void Usage(const char *name)
+{
+	printf(" Usage: %s [options]\n", name);
+	printf("  --emulate            run against the emulated bus\n");
+	printf("  --port <device>      serial port (default /dev/ttyUSB0)\n");
+	printf("  --id <n,n,...>       joints to step (default every joint that answers)\n");
+	printf("  --step <n>           goal step in position units (default %d)\n", DEFAULT_STEP);
+	printf("  --window <msec>      time traced after each step (default %d)\n", DEFAULT_WINDOW);
+	printf("  --period <msec>      bulk read period, 0 reads back to back (default %d)\n", MotionModule::TIME_UNIT);
+	printf("  --protocol <1|2>     Dynamixel protocol (default 1)\n");
+	printf("  --save [file]        store the result in [%s] of the ini file\n", RESPONSE_SECTION);
+	printf("                       (default %s)\n", INI_FILE_PATH);
+}
+
+static void WriteGoal(ArbotixPro *cm, int id, int goal)
+{
+	int param[3];
+
+	param[0] = id;
+	param[1] = ArbotixPro::GetLowByte(goal);
+	param[2] = ArbotixPro::GetHighByte(goal);
+	cm->SyncWrite(AXDXL::P_GOAL_POSITION_L, 3, 1, param);
+}
+
+// steps the joint from start to goal and traces it; the number of samples
+static int Trace(ArbotixPro *cm, int id, int goal)
+{
+	int num = 0;
+
+	WriteGoal(cm, id, goal);
+	// the servo takes the goal once the packet is out
+	double sent = cm->GetCurrentTime();
+	double next = sent;
+
+	while (num < MAXNUM_SAMPLE)
+		{
+			double now = cm->GetCurrentTime();
+			if (now - sent > gWindow)
+				break;
+			if (now < next)
+				{
+					usleep((useconds_t)((next - now) * 1000.0));
+					continue;
+				}
+			next += gPeriod;
+
+			if (cm->BulkRead() != ArbotixPro::SUCCESS || cm->m_BulkReadData[id].error != 0)
+				continue;
+			gTime[num] = cm->GetSensorTime() - sent;
+			gPosition[num] = cm->m_BulkReadData[id].ReadWord(AXDXL::P_PRESENT_POSITION_L);
+			num++;
+		}
+
+	return num;
+}
+
+// one step out and one back; the fit is the mean of the directions that fitted
+static bool Measure(ArbotixPro *cm, ServoResponse *response, int id, int start)
+{
+	int goal = (start + gStep <= AXDXL::MAX_VALUE) ? start + gStep : start - gStep;
+	int from[2] = { start, goal };
+	int to[2] = { goal, start };
+	double delay = 0.0, tau = 0.0;
+	int fitted = 0;
+
+	for (int i = 0; i < 2; i++)
+		{
+			usleep(SETTLE_TIME * 1000);
+			int num = Trace(cm, id, to[i]);
+			if (response->Fit(id, num, gTime, gPosition, from[i], to[i]) == true)
+				{
+					delay += response->GetDelay(id);
+					tau += response->GetTau(id);
+					fitted++;
+				}
+		}
+
+	if (fitted == 0)
+		return false;
+
+	response->Set(id, delay / fitted, tau / fitted);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	signal(SIGABRT, &sighandler);
+	signal(SIGTERM, &sighandler);
+	signal(SIGQUIT, &sighandler);
+	signal(SIGINT, &sighandler);
+
+	bool emulate = false;
+	const char *port = "/dev/ttyUSB0";
+	const char *ini_path = 0;
+	bool selected[JointData::NUMBER_OF_JOINTS];
+	bool select_all = true;
+
+	for (int id = 0; id < JointData::NUMBER_OF_JOINTS; id++)
+		selected[id] = false;
+
+	for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--emulate") == 0)
+				emulate = true;
+			else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+				port = argv[++i];
+			else if (strcmp(argv[i], "--id") == 0 && i + 1 < argc)
+				{
+					char buffer[128];
+					strncpy(buffer, argv[++i], sizeof(buffer) - 1);
+					buffer[sizeof(buffer) - 1] = 0;
+					for (char *token = strtok(buffer, ","); token != 0; token = strtok(0, ","))
+						{
+							int id = atoi(token);
+							if (id >= JointData::ID_MIN && id <= JointData::ID_MAX)
+								selected[id] = true;
+						}
+					select_all = false;
+				}
+			else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc)
+				gStep = atoi(argv[++i]);
+			else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+				gWindow = atof(argv[++i]);
+			else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc)
+				gPeriod = atof(argv[++i]);
+			else if (strcmp(argv[i], "--protocol") == 0 && i + 1 < argc)
+				gProtocol = atoi(argv[++i]);
+			else if (strcmp(argv[i], "--save") == 0)
+				ini_path = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : INI_FILE_PATH;
+			else
+				{
+					Usage(argv[0]);
+					return 0;
+				}
+		}
+
+	if (gStep <= 0 || gStep > AXDXL::MAX_VALUE / 2 || gWindow <= 0.0 || gPeriod < 0.0
+			|| (gProtocol != ArbotixPro::PROTOCOL_1 && gProtocol != ArbotixPro::PROTOCOL_2))
+		{
+			Usage(argv[0]);
+			return 0;
+		}
+
+	printf("\n[Servo Response Calibration for DARwIn %s]\n", PROGRAM_VERSION);
+
+	LinuxArbotixProEmulator *emulator = 0;
+	PlatformArbotixPro *platform;
+	if (emulate == true)
+		{
+			emulator = new LinuxArbotixProEmulator();
+			emulator->SetProtocol(gProtocol);
+			platform = emulator;
+		}
+	else
+		platform = new LinuxArbotixPro(port);
+
+	ArbotixPro *cm = new ArbotixPro(platform);
+	cm->SetProtocol(gProtocol);
+	if (cm->Connect() == false)
+		{
+			fprintf(stderr, " Fail to connect the Arbotix Pro\n");
+			return 0;
+		}
+
+	// earlier results of the joints not stepped now are kept
+	minIni *ini = (ini_path != 0) ? new minIni(ini_path) : 0;
+	ServoResponse response;
+	if (ini != 0)
+		response.LoadINISettings(ini);
+
+	// only the joint being stepped is read, position only
+	cm->SetFeedback(ArbotixPro::FEEDBACK_POSITION);
+	cm->SetSlowFeedback(ArbotixPro::FEEDBACK_NONE, 0);
+
+	printf(" step %d, traced %.0fmsec every %.1fmsec\n\n", gStep, gWindow, gPeriod);
+	printf(" %3s %9s %9s %9s\n", "ID", "DELAY(ms)", "TAU(ms)", "LAG(ms)");
+
+	int measured = 0;
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		{
+			if (select_all == false && selected[id] == false)
+				continue;
+
+			int start;
+			if (cm->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &start, 0) != ArbotixPro::SUCCESS)
+				{
+					if (select_all == false)
+						printf(" %3d   does not answer\n", id);
+					continue;
+				}
+
+			for (int i = JointData::ID_MIN; i <= JointData::ID_MAX; i++)
+				MotionStatus::m_CurrentJoints.SetEnable(i, i == id);
+			cm->MakeBulkReadPacket();
+
+			// hold the present position with torque on before stepping
+			WriteGoal(cm, id, start);
+			cm->WriteByte(id, AXDXL::P_TORQUE_ENABLE, 1, 0);
+
+			if (Measure(cm, &response, id, start) == true)
+				{
+					printf(" %3d %9.2f %9.2f %9.2f\n", id, response.GetDelay(id), response.GetTau(id),
+					       response.GetDelay(id) + response.GetTau(id));
+					measured++;
+				}
+			else
+				printf(" %3d   did not follow the step\n", id);
+
+			WriteGoal(cm, id, start);
+		}
+
+	if (ini != 0 && measured > 0)
+		{
+			response.SaveINISettings(ini);
+			printf("\n Saved to [%s] of %s\n", RESPONSE_SECTION, ini_path);
+		}
+
+	printf("\n");
+	return 0;
+}
@@ -0,0 +1,416 @@
+/*
+ *   main.cpp
+ *
+ *   Offline decoder of the bus trace files written by LinuxPacketCapture
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LinuxDARwIn.h"
+
+
+#define PROGRAM_VERSION		"v1.00"
+#define MAXNUM_STREAM		(1 << 17)
+
+#define INST_PING			(1)
+#define INST_READ			(2)
+#define INST_WRITE			(3)
+#define INST_REG_WRITE		(4)
+#define INST_ACTION			(5)
+#define INST_RESET			(6)
+#define INST_SYNC_WRITE		(131)   // 0x83
+#define INST_BULK_READ      (146)   // 0x92
+#define INST_FAST_BULK_READ (154)   // 0x9A, Protocol 2.0
+#define INST_STATUS         (85)    // 0x55, Protocol 2.0
+
+using namespace Robot;
+
+
+class Frame
+{
+	public:
+		double time;				// msec from the start of the trace
+		int direction;
+		int protocol;
+		int id;
+		int instruction;			// INST_xxx, INST_STATUS for every status packet
+		int error;
+		bool valid;					// checksum or CRC matched
+		const unsigned char *data;
+		int length;
+};
+
+// the bytes of one direction, split in packets as they complete
+class Stream
+{
+	public:
+		unsigned char data[MAXNUM_STREAM];
+		int length;
+		unsigned long noise;		// bytes that were not part of a packet
+
+		Stream() : length(0), noise(0) {}
+};
+
+class Gap
+{
+	public:
+		unsigned int count;
+		double sum;
+		double max;
+		double at;
+
+		Gap() : count(0), sum(0.0), max(0.0), at(0.0) {}
+		void Add(double gap, double time)
+		{
+			count++;
+			sum += gap;
+			if (gap > max)
+				{
+					max = gap;
+					at = time;
+				}
+		}
+};
+
+static int gFilterID = -1;
+static int gFilterInst = -1;
+static bool gHex = false;
+static bool gGaps = false;
+
+static unsigned long gShown = 0;
+static double gLastShown = -1.0;
+static double gLastTx = -1.0;
+static bool gAnswered = true;
+static Gap gTxToTx, gTxToRx, gAny;
+
+static const char* GetInstructionName(int instruction)
+{
+	switch (instruction)
+		{
+		case INST_PING:
+			return "PING";
+		case INST_READ:
+			return "READ";
+		case INST_WRITE:
+			return "WRITE";
+		case INST_REG_WRITE:
+			return "REG_WRITE";
+		case INST_ACTION:
+			return "ACTION";
+		case INST_RESET:
+			return "RESET";
+		case INST_SYNC_WRITE:
+			return "SYNC_WRITE";
+		case INST_BULK_READ:
+			return "BULK_READ";
+		case INST_FAST_BULK_READ:
+			return "FAST_BULK_READ";
+		case INST_STATUS:
+			return "STATUS";
+		default:
+			return "UNKNOWN";
+		}
+}
+
+static int ParseInstruction(const char *text)
+{
+	static const int list[] = { INST_PING, INST_READ, INST_WRITE, INST_REG_WRITE,
+	                            INST_ACTION, INST_RESET, INST_SYNC_WRITE, INST_BULK_READ,
+	                            INST_FAST_BULK_READ, INST_STATUS
+	                          };
+
+	for (unsigned int i = 0; i < sizeof(list) / sizeof(list[0]); i++)
+		{
+			if (strcasecmp(text, GetInstructionName(list[i])) == 0)
+				return list[i];
+		}
+
+	return atoi(text);
+}
+
+// true when the packet is addressed to the ID or carries data for it
+static bool Mentions(Frame *frame, int id)
+{
+	const unsigned char *d = frame->data;
+
+	if (frame->id == id)
+		return true;
+	if (frame->id != ArbotixPro::ID_BROADCAST || frame->direction != PacketCapture::DIRECTION_TX)
+		return false;
+
+	if (frame->protocol == ArbotixPro::PROTOCOL_1)
+		{
+			int end = frame->length - 1;
+			if (frame->instruction == INST_SYNC_WRITE)
+				{
+					for (int i = 7; i < end; i += d[6] + 1)
+						if (d[i] == id)
+							return true;
+				}
+			else if (frame->instruction == INST_BULK_READ)
+				{
+					for (int i = 7; i < end; i += 3)
+						if (d[i] == id)
+							return true;
+				}
+		}
+	else
+		{
+			int end = frame->length - 2;
+			if (frame->instruction == INST_SYNC_WRITE)
+				{
+					int each = ArbotixPro::MakeWord(d[10], d[11]) + 1;
+					for (int i = 12; i < end; i += each)
+						if (d[i] == id)
+							return true;
+				}
+			else if (frame->instruction == INST_FAST_BULK_READ || frame->instruction == INST_BULK_READ)
+				{
+					for (int i = 8; i < end; i += 5)
+						if (d[i] == id)
+							return true;
+				}
+		}
+
+	return false;
+}
+
+static void Show(Frame *frame)
+{
+	if (frame->direction == PacketCapture::DIRECTION_TX)
+		{
+			if (gLastTx >= 0.0)
+				gTxToTx.Add(frame->time - gLastTx, frame->time);
+			gLastTx = frame->time;
+			gAnswered = false;
+		}
+	else if (gAnswered == false)
+		{
+			gTxToRx.Add(frame->time - gLastTx, frame->time);
+			gAnswered = true;
+		}
+
+	if (gFilterID >= 0 && Mentions(frame, gFilterID) == false)
+		return;
+	if (gFilterInst >= 0 && frame->instruction != gFilterInst)
+		return;
+
+	double gap = (gLastShown >= 0.0) ? frame->time - gLastShown : 0.0;
+	if (gLastShown >= 0.0)
+		gAny.Add(gap, frame->time);
+	gLastShown = frame->time;
+	gShown++;
+
+	printf(" %12.3f %+9.3f  %s  ID %3d  %-14s %4d bytes", frame->time, gap,
+	       frame->direction == PacketCapture::DIRECTION_TX ? "TX" : "RX", frame->id,
+	       GetInstructionName(frame->instruction), frame->length);
+	if (frame->instruction == INST_STATUS && frame->error != 0)
+		printf("  ERR 0x%.2X", frame->error);
+	if (frame->valid == false)
+		printf("  BAD CHECKSUM");
+	printf("\n");
+
+	if (gHex == true)
+		{
+			for (int i = 0; i < frame->length; i++)
+				printf("%s%.2X", (i % 24 == 0) ? "\n      " : " ", frame->data[i]);
+			printf("\n\n");
+		}
+}
+
+// length of the packet at the start of the data, 0 while it is incomplete
+// and -1 when the data does not start with a header
+static int GetPacketLength(const unsigned char *d, int length, int protocol)
+{
+	if (protocol == ArbotixPro::PROTOCOL_2)
+		{
+			if (length >= 1 && d[0] != 0xFF) return -1;
+			if (length >= 2 && d[1] != 0xFF) return -1;
+			if (length >= 3 && d[2] != 0xFD) return -1;
+			if (length >= 4 && d[3] != 0x00) return -1;
+			if (length < 7)
+				return 0;
+			int total = ArbotixPro::MakeWord(d[5], d[6]) + 7;
+			return (length >= total) ? total : 0;
+		}
+
+	if (length >= 1 && d[0] != 0xFF) return -1;
+	if (length >= 2 && d[1] != 0xFF) return -1;
+	if (length >= 3 && d[2] == 0xFF) return -1;
+	if (length < 4)
+		return 0;
+	int total = d[3] + 4;
+	return (length >= total) ? total : 0;
+}
+
+static void Decode(Stream *stream, int direction, int protocol, double time)
+{
+	int pos = 0;
+
+	while (pos < stream->length)
+		{
+			const unsigned char *d = &stream->data[pos];
+			int total = GetPacketLength(d, stream->length - pos, protocol);
+			if (total < 0)
+				{
+					stream->noise++;
+					pos++;
+					continue;
+				}
+			if (total == 0)
+				break;
+
+			Frame frame;
+			frame.time = time;
+			frame.direction = direction;
+			frame.protocol = protocol;
+			frame.data = d;
+			frame.length = total;
+			if (protocol == ArbotixPro::PROTOCOL_2)
+				{
+					frame.id = d[4];
+					frame.instruction = d[7];
+					frame.error = (total > 8) ? d[8] : 0;
+					frame.valid = (ArbotixPro::UpdateCRC(0, d, total - 2) == ArbotixPro::MakeWord(d[total - 2], d[total - 1]));
+				}
+			else
+				{
+					unsigned char checksum = 0;
+					for (int i = 2; i < total - 1; i++)
+						checksum += d[i];
+					frame.id = d[2];
+					frame.instruction = (direction == PacketCapture::DIRECTION_TX) ? d[4] : INST_STATUS;
+					frame.error = d[4];
+					frame.valid = ((unsigned char)~checksum == d[total - 1]);
+				}
+
+			Show(&frame);
+			pos += total;
+		}
+
+	memmove(stream->data, &stream->data[pos], stream->length - pos);
+	stream->length -= pos;
+}
+
+static void PrintGap(const char *name, Gap *gap)
+{
+	if (gap->count == 0)
+		return;
+	printf(" %-16s %8u %10.3f %10.3f %12.3f\n", name, gap->count, gap->sum / gap->count, gap->max, gap->at);
+}
+
+static void Usage(const char *name)
+{
+	printf(" Usage: %s [options] <trace file>\n", name);
+	printf("  --id <n>       only packets to, from or carrying data for ID n\n");
+	printf("  --inst <name>  only this instruction (PING, READ, WRITE, SYNC_WRITE, BULK_READ,\n");
+	printf("                 FAST_BULK_READ, STATUS, ... or the number)\n");
+	printf("  --hex          print the raw bytes of every packet\n");
+	printf("  --gaps         print the gaps between packets at the end\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = 0;
+
+	for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--id") == 0 && i + 1 < argc)
+				gFilterID = atoi(argv[++i]);
+			else if (strcmp(argv[i], "--inst") == 0 && i + 1 < argc)
+				gFilterInst = ParseInstruction(argv[++i]);
+			else if (strcmp(argv[i], "--hex") == 0)
+				gHex = true;
+			else if (strcmp(argv[i], "--gaps") == 0)
+				gGaps = true;
+			else if (argv[i][0] != '-' && path == 0)
+				path = argv[i];
+			else
+				{
+					Usage(argv[0]);
+					return 0;
+				}
+		}
+
+	if (path == 0)
+		{
+			Usage(argv[0]);
+			return 0;
+		}
+
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL)
+		{
+			fprintf(stderr, " Can not open %s\n", path);
+			return 1;
+		}
+
+	unsigned char header[PacketCapture::FILE_HEADER_SIZE];
+	if (fread(header, 1, PacketCapture::FILE_HEADER_SIZE, fp) != PacketCapture::FILE_HEADER_SIZE
+	        || memcmp(header, PacketCapture::MAGIC, sizeof(PacketCapture::MAGIC)) != 0)
+		{
+			fprintf(stderr, " %s is not a bus trace\n", path);
+			fclose(fp);
+			return 1;
+		}
+	if (ArbotixPro::MakeWord(header[8], header[9]) != PacketCapture::VERSION)
+		{
+			fprintf(stderr, " Trace version %d is not supported\n", ArbotixPro::MakeWord(header[8], header[9]));
+			fclose(fp);
+			return 1;
+		}
+
+	printf("\n[Dynamixel Bus Trace Decoder for DARwIn %s]\n\n", PROGRAM_VERSION);
+	printf(" %12s %9s  %s  %6s  %-14s %s\n", "TIME(ms)", "GAP(ms)", "  ", "ID", "INSTRUCTION", "LENGTH");
+
+	static Stream stream[2];
+	unsigned char record[PacketCapture::HEADER_SIZE];
+	unsigned long long first = 0;
+	unsigned long records = 0;
+
+	while (fread(record, 1, PacketCapture::HEADER_SIZE, fp) == PacketCapture::HEADER_SIZE)
+		{
+			unsigned long long nsec = 0;
+			for (int i = 7; i >= 0; i--)
+				nsec = (nsec << 8) | record[i];
+			int length = ArbotixPro::MakeWord(record[8], record[9]);
+			int direction = record[10] & 1;
+			int protocol = record[11];
+
+			Stream *s = &stream[direction];
+			if (s->length + length > MAXNUM_STREAM)
+				{
+					s->noise += s->length;
+					s->length = 0;
+				}
+			if ((int)fread(&s->data[s->length], 1, length, fp) != length)
+				break;
+			s->length += length;
+
+			if (records++ == 0)
+				first = nsec;
+			// a port write always holds whole packets, what is left is garbage
+			Decode(s, direction, protocol, (double)(nsec - first) / 1000000.0);
+			if (direction == PacketCapture::DIRECTION_TX)
+				{
+					s->noise += s->length;
+					s->length = 0;
+				}
+		}
+	fclose(fp);
+
+	printf("\n %lu records, %lu packets shown, %lu TX and %lu RX bytes outside packets\n",
+	       records, gShown, stream[0].noise, stream[1].noise + stream[1].length);
+
+	if (gGaps == true)
+		{
+			printf("\n %-16s %8s %10s %10s %12s\n", "GAP", "COUNT", "AVG(ms)", "MAX(ms)", "MAX AT(ms)");
+			PrintGap("TX -> TX", &gTxToTx);
+			PrintGap("TX -> first RX", &gTxToRx);
+			PrintGap("shown packets", &gAny);
+		}
+	printf("\n");
+
+	return 0;
+}
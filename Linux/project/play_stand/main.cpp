@@ -108,7 +108,8 @@ void walk(int direction, int second)
     for (int i = 0; i < second; i++) {
 
         // Check if we've fallen over
-        if (MotionStatus::FALLEN != STANDUP)
+        MotionSnapshot status = MotionStatus::Snapshot();
+        if (status.FALLEN != STANDUP)
         {
             // Stop walking
             Walking::GetInstance()->Stop();
@@ -122,9 +123,9 @@ void walk(int direction, int second)
             linuxMotionTimer.Stop();
 
             // Run the stand-up motions
-            cout << "Robot fallen " << MotionStatus::FALLEN << ".\n";
+            cout << "Robot fallen " << status.FALLEN << ".\n";
             usleep(500 * 1000);
-            stand_up(MotionStatus::FALLEN);
+            stand_up(status.FALLEN);
             usleep(500 * 1000);
 
             // Resume walking
@@ -207,7 +208,8 @@ void turn(int degrees_to_turn)
         cout << "Current heading: " << current_heading << "\n";
 
         // Check if we've fallen over
-        if (MotionStatus::FALLEN != STANDUP)
+        MotionSnapshot status = MotionStatus::Snapshot();
+        if (status.FALLEN != STANDUP)
         {
             // Stop walking
             Walking::GetInstance()->Stop();
@@ -222,9 +224,9 @@ void turn(int degrees_to_turn)
             linuxMotionTimer.Stop();
 
             // Run the stand-up motions
-            cout << "Robot fallen " << MotionStatus::FALLEN << ".\n";
+            cout << "Robot fallen " << status.FALLEN << ".\n";
             usleep(500 * 1000);
-            stand_up(MotionStatus::FALLEN);
+            stand_up(status.FALLEN);
             usleep(500 * 1000);
 
             // Resume walking
@@ -334,7 +336,8 @@ void turnCompass(int degrees_to_turn)
         cout << "Current heading: " << current_heading << "\n";
 
         // Check if we've fallen over
-        if (MotionStatus::FALLEN != STANDUP)
+        MotionSnapshot status = MotionStatus::Snapshot();
+        if (status.FALLEN != STANDUP)
         {
             // Stop walking
             Walking::GetInstance()->Stop();
@@ -349,9 +352,9 @@ void turnCompass(int degrees_to_turn)
             linuxMotionTimer.Stop();
 
             // Run the stand-up motions
-            cout << "Robot fallen " << MotionStatus::FALLEN << ".\n";
+            cout << "Robot fallen " << status.FALLEN << ".\n";
             usleep(500 * 1000);
-            stand_up(MotionStatus::FALLEN);
+            stand_up(status.FALLEN);
             usleep(500 * 1000);
 
             // Resume walking
@@ -428,7 +431,7 @@ int main(int argc, char *argv[])
     //httpd::ini = ini;
 
     //////////////////// Framework Initialize ////////////////////////////
-    if (MotionManager::GetInstance()->Initialize(&arbotixpro) == false)
+    if (MotionManager::GetInstance()->Initialize(&arbotixpro, ini) == false)
 	{
 		printf("Fail to initialize Motion Manager!\n");
 		return 0;
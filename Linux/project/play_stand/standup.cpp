@@ -30,7 +30,7 @@ void PrintCmd(const char *message)
 
 void PlayCmd(ArbotixPro *arbotixpro, int pageNum)
 {
-	int value, oldIndex = 0;
+	int oldIndex = 0;
 	Action::PAGE page;
 
     // Check if we can load the page
@@ -56,16 +56,19 @@ void PlayCmd(ArbotixPro *arbotixpro, int pageNum)
     }
 
     // Initialie the joints?
+    // (torque, goal and present position of every joint in one bulk read)
+    int joints[JointData::NUMBER_OF_JOINTS], num = 0;
+    Pose pose;
+	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+        joints[num++] = id;
+    arbotixpro->CapturePose(num, joints, ArbotixPro::POSE_TORQUE | ArbotixPro::POSE_GOAL | ArbotixPro::FEEDBACK_POSITION, &pose);
 	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++) {
-        if (arbotixpro->ReadByte(id, AXDXL::P_TORQUE_ENABLE, &value, 0) == ArbotixPro::SUCCESS) {
-            if (value == 0) {
-                if (arbotixpro->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &value, 0) == ArbotixPro::SUCCESS)
-                    MotionStatus::m_CurrentJoints.SetValue(id, value);
-            } else {
-                if (arbotixpro->ReadWord(id, AXDXL::P_GOAL_POSITION_L, &value, 0) == ArbotixPro::SUCCESS)
-                    MotionStatus::m_CurrentJoints.SetValue(id, value);
-            }
-        }
+        if (pose.valid[id] == false)
+            continue;
+        if (pose.torque[id] == 0)
+            MotionStatus::m_CurrentJoints.SetValue(id, pose.position[id]);
+        else
+            MotionStatus::m_CurrentJoints.SetValue(id, pose.goal[id]);
     }
 
     // Run the motions
@@ -473,8 +473,9 @@ void StatusCheck::Check(ArbotixPro &arbotixpro)
 			int lx = 128, ly = 128;
 			int dead_band = 5;
 			double pan, tilt;
-			pan = MotionStatus::m_CurrentJoints.GetAngle(JointData::ID_HEAD_PAN);
-			tilt = MotionStatus::m_CurrentJoints.GetAngle(JointData::ID_HEAD_TILT);
+			MotionSnapshot status = MotionStatus::Snapshot();
+			pan = status.m_CurrentJoints.GetAngle(JointData::ID_HEAD_PAN);
+			tilt = status.m_CurrentJoints.GetAngle(JointData::ID_HEAD_TILT);
 			Point2D pos = Point2D(pan, tilt);
 
 #ifdef Southpaw
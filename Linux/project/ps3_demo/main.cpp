@@ -56,10 +56,10 @@ int main(int argc, char *argv[])
 	StatusCheck::m_ini1 = ini1;
 
 	//////////////////// Framework Initialize ////////////////////////////
-	if (MotionManager::GetInstance()->Initialize(&arbotixpro) == false)
+	if (MotionManager::GetInstance()->Initialize(&arbotixpro, ini) == false)
 		{
 			linux_arbotixpro.SetPortName(U2D_DEV_NAME1);
-			if (MotionManager::GetInstance()->Initialize(&arbotixpro) == false)
+			if (MotionManager::GetInstance()->Initialize(&arbotixpro, ini) == false)
 				{
 					printf("Fail to initialize Motion Manager!\n");
 					return 0;
@@ -224,16 +224,21 @@ int GetCurrentPosition(ArbotixPro &arbotixpro)
 		{
 			pos[p]	= -1;
 		}
+	// both legs in one bulk read
+	int legs[12];
+	Pose pose;
 	for (p = 0; p < 6; p++)
 		{
-			if (arbotixpro.ReadWord(rl[p], AXDXL::P_PRESENT_POSITION_L, &pos[rl[p]], 0) != ArbotixPro::SUCCESS)
-				{
-					printf("Failed to read position %d", rl[p]);
-				}
-			if (arbotixpro.ReadWord(ll[p], AXDXL::P_PRESENT_POSITION_L, &pos[ll[p]], 0) != ArbotixPro::SUCCESS)
-				{
-					printf("Failed to read position %d", ll[p]);
-				}
+			legs[p] = rl[p];
+			legs[p + 6] = ll[p];
+		}
+	arbotixpro.CapturePose(12, legs, ArbotixPro::FEEDBACK_POSITION, &pose);
+	for (p = 0; p < 12; p++)
+		{
+			if (pose.valid[legs[p]] == true)
+				pos[legs[p]] = pose.position[legs[p]];
+			else
+				printf("Failed to read position %d", legs[p]);
 		}
 	// compare to a couple poses
 	// first sitting - page 48
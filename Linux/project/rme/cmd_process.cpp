@@ -127,27 +127,29 @@ void reset_stdin(void)
 	tcsetattr(0, TCSANOW, &oldterm);
 }
 
+// the torque, goal and present position of every joint in one bulk read
+static void CaptureJoints(ArbotixPro *arbotixpro, Pose *pose)
+{
+	int id[JointData::NUMBER_OF_JOINTS];
+	int num = 0;
+
+	for (int i = JointData::ID_MIN; i <= JointData::ID_MAX; i++)
+		id[num++] = i;
+	arbotixpro->CapturePose(num, id, ArbotixPro::POSE_TORQUE | ArbotixPro::POSE_GOAL | ArbotixPro::FEEDBACK_POSITION, pose);
+}
+
 void ReadStep(ArbotixPro *arbotixpro)
 {
-	int value;
+	Pose pose;
+	CaptureJoints(arbotixpro, &pose);
 	for (int id = 0; id < 31; id++)
 		{
-			if (id >= JointData::ID_MIN && id <= JointData::ID_MAX)
+			if (id >= JointData::ID_MIN && id <= JointData::ID_MAX && pose.valid[id] == true)
 				{
-					if (arbotixpro->ReadByte(id, AXDXL::P_TORQUE_ENABLE, &value, 0) == ArbotixPro::SUCCESS)
-						{
-							if (value == 1)
-								{
-									if (arbotixpro->ReadWord(id, AXDXL::P_GOAL_POSITION_L, &value, 0) == ArbotixPro::SUCCESS)
-										Step.position[id] = value;
-									else
-										Step.position[id] = Action::INVALID_BIT_MASK;
-								}
-							else
-								Step.position[id] = Action::TORQUE_OFF_BIT_MASK;
-						}
+					if (pose.torque[id] == 1)
+						Step.position[id] = pose.goal[id];
 					else
-						Step.position[id] = Action::INVALID_BIT_MASK;
+						Step.position[id] = Action::TORQUE_OFF_BIT_MASK;
 				}
 			else
 				Step.position[id] = Action::INVALID_BIT_MASK;
@@ -1158,7 +1160,7 @@ void MonitorServos(ArbotixPro *arbotixpro)
 void PlayCmd(ArbotixPro *arbotixpro, int pageNum)
 {
   char *timestring;
-	int value, oldIndex = 0;
+	int oldIndex = 0;
   struct timeval t1, t2;
 	Action::PAGE page;
 
@@ -1189,21 +1191,16 @@ void PlayCmd(ArbotixPro *arbotixpro, int pageNum)
 				}
 		}
 
+	Pose pose;
+	CaptureJoints(arbotixpro, &pose);
 	for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
 		{
-			if (arbotixpro->ReadByte(id, AXDXL::P_TORQUE_ENABLE, &value, 0) == ArbotixPro::SUCCESS)
-				{
-					if (value == 0)
-						{
-							if (arbotixpro->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &value, 0) == ArbotixPro::SUCCESS)
-								MotionStatus::m_CurrentJoints.SetValue(id, value);
-						}
-					else
-						{
-							if (arbotixpro->ReadWord(id, AXDXL::P_GOAL_POSITION_L, &value, 0) == ArbotixPro::SUCCESS)
-								MotionStatus::m_CurrentJoints.SetValue(id, value);
-						}
-				}
+			if (pose.valid[id] == false)
+				continue;
+			if (pose.torque[id] == 0)
+				MotionStatus::m_CurrentJoints.SetValue(id, pose.position[id]);
+			else
+				MotionStatus::m_CurrentJoints.SetValue(id, pose.goal[id]);
 		}
 	PrintCmd("Playing... ('s' to stop, 'b' to brake)");
 
@@ -1432,6 +1429,18 @@ void ListCmd()
 		}
 }
 
+static void AddJoint(int *joints, int *num, int id)
+{
+	if (id < JointData::ID_MIN || id > JointData::ID_MAX)
+		return;
+	for (int i = 0; i < *num; i++)
+		{
+			if (joints[i] == id)
+				return;
+		}
+	joints[(*num)++] = id;
+}
+
 void OnOffCmd(ArbotixPro *arbotixpro, bool on, int num_param, int *list, char lists[30][10])
 {
 	char *token, token1[30];
@@ -1441,11 +1450,13 @@ void OnOffCmd(ArbotixPro *arbotixpro, bool on, int num_param, int *list, char li
 	int ra[6] = { JointData::ID_R_SHOULDER_PITCH, JointData::ID_R_SHOULDER_ROLL, JointData::ID_R_ELBOW };
 	int la[6] = { JointData::ID_L_SHOULDER_PITCH, JointData::ID_L_SHOULDER_ROLL, JointData::ID_L_ELBOW };
 	int h[3] = { JointData::ID_HEAD_PAN, JointData::ID_HEAD_TILT };
+	int joints[JointData::NUMBER_OF_JOINTS];
+	int num = 0;
 
 	if (num_param == 0)
 		{
-			for (int id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
-				arbotixpro->WriteByte(id, AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+			for (id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+				joints[num++] = id;
 		}
 	else
 		{
@@ -1463,7 +1474,7 @@ void OnOffCmd(ArbotixPro *arbotixpro, bool on, int num_param, int *list, char li
 									if (stopID >= JointData::ID_MIN && stopID <= JointData::ID_MAX && startID >= JointData::ID_MIN && startID <= JointData::ID_MAX)
 										{
 											for (id = startID; id <= stopID; id++)
-												arbotixpro->WriteByte(id, AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+												AddJoint(joints, &num, id);
 										}
 								}
 							else
@@ -1471,34 +1482,36 @@ void OnOffCmd(ArbotixPro *arbotixpro, bool on, int num_param, int *list, char li
 									if (strcmp(token1, "rl") == 0)
 										{
 											for (id = 0; id < 6; id++ )
-												arbotixpro->WriteByte(rl[id], AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+												AddJoint(joints, &num, rl[id]);
 										}
 									else if (strcmp(token1, "ll") == 0)
 										{
 											for (id = 0; id < 6; id++ )
-												arbotixpro->WriteByte(ll[id], AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+												AddJoint(joints, &num, ll[id]);
 										}
 									else if (strcmp(token1, "ra") == 0)
 										{
 											for (id = 0; id < 6; id++ )
-												arbotixpro->WriteByte(ra[id], AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+												AddJoint(joints, &num, ra[id]);
 										}
 									else if (strcmp(token1, "la") == 0)
 										{
 											for (id = 0; id < 6; id++ )
-												arbotixpro->WriteByte(la[id], AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+												AddJoint(joints, &num, la[id]);
 										}
 									else if (strcmp(token1, "h") == 0)
 										{
 											for (id = 0; id < 3; id++ )
-												arbotixpro->WriteByte(h[id], AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+												AddJoint(joints, &num, h[id]);
 										}
 									else if (list[i] >= JointData::ID_MIN && list[i] <= JointData::ID_MAX)
-										arbotixpro->WriteByte(list[i], AXDXL::P_TORQUE_ENABLE, (int)on, 0);
+										AddJoint(joints, &num, list[i]);
 								}
 						}
 				}
 		}
+	// every joint switched in one SYNC_WRITE
+	arbotixpro->ApplyPose(num, joints, 0, 0, (int)on);
 	ReadStep(arbotixpro);
 	DrawStep(7);
 }
@@ -1681,11 +1694,17 @@ void GoCmd(ArbotixPro *arbotixpro, int index)
 		}
 
 	int id;
-	int wStartPosition;
+	int joints[JointData::NUMBER_OF_JOINTS];
+	int num = 0;
+	Pose pose;
 	Action::PAGE tPage;
 
 	Action::GetInstance()->ResetPage(&tPage);
 
+	for (id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
+		joints[num++] = id;
+	arbotixpro->CapturePose(num, joints, ArbotixPro::FEEDBACK_POSITION, &pose);
+
 	for (id = JointData::ID_MIN; id <= JointData::ID_MAX; id++)
 		{
 			if (Page.step[index].position[id] & Action::INVALID_BIT_MASK)
@@ -1694,13 +1713,13 @@ void GoCmd(ArbotixPro *arbotixpro, int index)
 					return;
 				}
 
-			if (arbotixpro->ReadWord(id, AXDXL::P_PRESENT_POSITION_L, &wStartPosition, 0) != ArbotixPro::SUCCESS)
+			if (pose.valid[id] == false)
 				{
 					PrintCmd("Failed to read position");
 					return;
 				}
-			MotionStatus::m_CurrentJoints.SetValue(id, wStartPosition);
-			tPage.step[0].position[id] = wStartPosition;
+			MotionStatus::m_CurrentJoints.SetValue(id, pose.position[id]);
+			tPage.step[0].position[id] = pose.position[id];
 			tPage.step[1].position[id] = Page.step[index].position[id];
 
 		}
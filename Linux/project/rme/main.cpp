@@ -126,7 +126,7 @@ int main(int argc, char *argv[])
 
     //    PS3Controller_Start();
     //////////////////// Framework Initialize ////////////////////////////
-    if (MotionManager::GetInstance()->Initialize(&arbotixpro) == false)
+    if (MotionManager::GetInstance()->Initialize(&arbotixpro, ini) == false)
         {
             printf("Initializing Motion Manager failed!\n");
             exit(0);
@@ -272,17 +272,14 @@ int main(int argc, char *argv[])
                                         SpeedCmd();
                                     else if (strcmp(cmd, "mon") == 0)
                                         {
+                                            // the temperatures come in turn with the bulk read
                                             linuxMotionTimer.Start();
-                                            arbotixpro.m_bIncludeTempData = true;
-                                            arbotixpro.MakeBulkReadPacket();// force packet to get rebuilt
                                             while (!kbhit(true))
                                                 {
                                                     MonitorServos(&arbotixpro);
                                                     usleep(10000);
                                                 }
                                             linuxMotionTimer.Stop();
-                                            arbotixpro.m_bIncludeTempData = false;
-                                            arbotixpro.MakeBulkReadPacket();// force packet to be rebuilt
                                             GoToCursor(CMD_COL, CMD_ROW);
                                         }
                                     else if (strcmp(cmd, "page") == 0)
@@ -130,8 +130,17 @@ int main(int argc, char *argv[])
     //mjpg_streamer* streamer = new mjpg_streamer(0, 0);
     //httpd::ini = ini;
 
+    // a second Dynamixel chain on its own USB2Dynamixel, joints mapped by ID_xx
+    std::string port_name = ini->gets(PORT_SECTION, "port_1", "");
+    if (port_name != "")
+        {
+            ArbotixPro *port = new ArbotixPro(new LinuxArbotixPro(port_name.c_str()));
+            port->SetBoard(false);
+            MotionManager::GetInstance()->AddPort(port);
+        }
+
     //////////////////// Framework Initialize ////////////////////////////
-    if (MotionManager::GetInstance()->Initialize(&arbotixpro) == false)
+    if (MotionManager::GetInstance()->Initialize(&arbotixpro, ini) == false)
         {
             printf("Fail to initialize Motion Manager!\n");
             return 0;
@@ -61,6 +61,7 @@ int main(int argc, char *argv[])
     MotionManager::GetInstance()->AddModule((MotionModule*)Walking::GetInstance());
     LinuxMotionTimer linuxMotionTimer;
     linuxMotionTimer.Initialize(MotionManager::GetInstance());
+    linuxMotionTimer.LoadINISettings(ini);
     linuxMotionTimer.Start();
     /////////////////////////////////////////////////////////////////////
 
@@ -182,5 +183,7 @@ int main(int argc, char *argv[])
         }
 
     DrawEnding();
+    linuxMotionTimer.Stop();
+    MotionManager::GetInstance()->GetTickStatistics()->Print(stdout);
     exit(0);
 }